@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include "match_aligner.h"
+#include "source_lexer.h"
+
+namespace {
+
+// Random prose; the copy keeps most of it but rewrites a few words in
+// every hundred, so the matches are many medium-length spans.
+std::pair<std::string, std::string> make_pair_of_texts(size_t size) {
+    static const char* words[] = {
+        "analysis", "of", "the", "algorithm", "shows", "that", "each", "step",
+        "requires", "linear", "time", "and", "memory", "proportional", "to", "input",
+        "therefore", "we", "conclude", "result", "holds", "for", "all", "cases"
+    };
+    const size_t word_count = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 rng(11);
+    std::string original;
+    std::string copy;
+    original.reserve(size + 64);
+    copy.reserve(size + 64);
+
+    size_t emitted = 0;
+    while (original.size() < size) {
+        const char* word = words[rng() % word_count];
+        const char* gap = ++emitted % 12 == 0 ? "\n" : " ";
+
+        original += word;
+        original += gap;
+        copy += rng() % 100 < 3 ? words[rng() % word_count] : word;
+        copy += gap;
+    }
+    return {original, copy};
+}
+
+// Random C++ statements; the copy renames the variables and replaces about
+// one statement in thirty.
+std::pair<std::string, std::string> make_pair_of_sources(size_t size) {
+    static const char* statements[] = {
+        "    int {a} = {b} + 42;\n",
+        "    for (size_t i = 0; i < {a}.size(); ++i) {\n        {b} += {a}[i];\n    }\n",
+        "    if ({a} != nullptr && {b} >= 0x1F) {\n        return {a}->get({b});\n    }\n",
+        "    std::vector<double> {a}({b}, 3.5e-2);\n",
+        "    auto {a} = [&](const auto& x) { return x << {b}; };\n",
+        "    while ({a}-- > 0) { {b} = {b} * 31 ^ {a}; }\n",
+        "    {a}.push_back(std::make_pair({b}, \"key\"));\n"
+    };
+    static const char* names[2][3] = {{"total", "items", "cursor"}, {"sum", "values", "it"}};
+    const size_t statement_count = sizeof(statements) / sizeof(statements[0]);
+
+    auto expand = [](std::string line, const char* a, const char* b) {
+        for (size_t pos; (pos = line.find("{a}")) != std::string::npos;) {
+            line.replace(pos, 3, a);
+        }
+        for (size_t pos; (pos = line.find("{b}")) != std::string::npos;) {
+            line.replace(pos, 3, b);
+        }
+        return line;
+    };
+
+    std::mt19937 rng(13);
+    std::string original;
+    std::string copy;
+    while (original.size() < size) {
+        size_t statement = rng() % statement_count;
+        size_t a = rng() % 3;
+        size_t b = rng() % 3;
+        original += expand(statements[statement], names[0][a], names[0][b]);
+        size_t copied = rng() % 30 == 0 ? rng() % statement_count : statement;
+        copy += expand(statements[copied], names[1][a], names[1][b]);
+    }
+    return {original, copy};
+}
+
+template <typename Fn>
+double measure_ms(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+    auto texts = make_pair_of_texts(megabytes * 1024 * 1024);
+
+    std::vector<MatchAligner::Span> spans;
+    size_t symbols = 0;
+    double words_ms = measure_ms([&] {
+        auto source = MatchAligner::Document::from_words(texts.first);
+        auto target = MatchAligner::Document::from_words(texts.second);
+        symbols = source.size() + target.size();
+        spans = MatchAligner::align(source, target, 8, SIZE_MAX);
+    });
+    std::cout << "words:  " << megabytes << " MB vs " << megabytes << " MB, " << symbols << " symbols, "
+              << spans.size() << " spans in " << words_ms << " ms" << std::endl;
+
+    auto sources = make_pair_of_sources(megabytes * 1024 * 1024);
+    SourceLexer lexer;
+    double tokens_ms = measure_ms([&] {
+        const auto& source_tokens = lexer.tokenize(sources.first, SourceLexer::Language::Cpp, true);
+        auto source = MatchAligner::Document::from_tokens(sources.first, source_tokens, lexer.last_positions());
+        const auto& target_tokens = lexer.tokenize(sources.second, SourceLexer::Language::Cpp, true);
+        auto target = MatchAligner::Document::from_tokens(sources.second, target_tokens, lexer.last_positions());
+        symbols = source.size() + target.size();
+        spans = MatchAligner::align(source, target, 12, 200);
+    });
+    std::cout << "tokens: " << megabytes << " MB vs " << megabytes << " MB, " << symbols << " symbols, "
+              << spans.size() << " spans in " << tokens_ms << " ms" << std::endl;
+
+    return spans.empty() ? 1 : 0;
+}
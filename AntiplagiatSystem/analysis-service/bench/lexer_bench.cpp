@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "source_lexer.h"
+#include "text_normalizer.h"
+
+namespace {
+
+// Random C++-like functions; `variant` changes identifier names and comment
+// wording but not the structure, as a renamed copy would.
+std::string make_cpp_corpus(size_t functions, int variant) {
+    static const char* statements[] = {
+        "    int {a} = {b} + 42;\n",
+        "    for (size_t {a} = 0; {a} < {b}.size(); ++{a}) {\n        {b}[{a}] *= 2;\n    }\n",
+        "    if ({a} != nullptr && {b} >= 0x1F) {\n        return {a}->{b}(\"value: %d\\n\", {b});\n    }\n",
+        "    std::vector<std::pair<int, double>> {a}{{b}, 3.5e-2};\n",
+        "    // {c}\n",
+        "    /* {c}\n       {c} */\n",
+        "    auto {a} = [&](const auto& {b}) { return {b} << 1; };\n",
+        "    {a} += '\\'' + {b};\n",
+        "    while ({a}-- > 0) { {b} = {b} * 31 ^ {a}; }\n"
+    };
+    static const char* names[2][4] = {
+        {"count", "items", "result", "buffer"},
+        {"n", "values", "answer", "storage"}
+    };
+    static const char* comments[2][3] = {
+        {"compute the running total", "TODO: handle overflow", "see issue 17"},
+        {"sum everything up", "overflow is not possible here", "fixed later"}
+    };
+
+    std::mt19937 rng(7);
+    std::string corpus;
+    for (size_t f = 0; f < functions; ++f) {
+        corpus += "int function_" + std::to_string(f) + "(int arg) {\n";
+        for (int i = 0; i < 8; ++i) {
+            std::string line = statements[rng() % (sizeof(statements) / sizeof(statements[0]))];
+            const char* a = names[variant][rng() % 4];
+            const char* b = names[variant][rng() % 4];
+            const char* c = comments[variant][rng() % 3];
+
+            std::string expanded;
+            for (size_t pos = 0; pos < line.size(); ++pos) {
+                if (line.compare(pos, 3, "{a}") == 0) {
+                    expanded += a;
+                    pos += 2;
+                } else if (line.compare(pos, 3, "{b}") == 0) {
+                    expanded += b;
+                    pos += 2;
+                } else if (line.compare(pos, 3, "{c}") == 0) {
+                    expanded += c;
+                    pos += 2;
+                } else {
+                    expanded += line[pos];
+                }
+            }
+            corpus += expanded;
+        }
+        corpus += "}\n\n";
+    }
+    return corpus;
+}
+
+template <typename Fn>
+double measure_ms(Fn&& fn, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count() / iterations;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // About 600 bytes per generated function.
+    size_t functions = megabytes * 1024 * 1024 / 600;
+    std::string original = make_cpp_corpus(functions, 0);
+    std::string renamed = make_cpp_corpus(functions, 1);
+    double corpus_mb = original.size() / (1024.0 * 1024.0);
+
+    SourceLexer lexer;
+    std::vector<uint16_t> original_tokens = lexer.tokenize(original, SourceLexer::Language::Cpp);
+    std::vector<uint16_t> renamed_tokens = lexer.tokenize(renamed, SourceLexer::Language::Cpp);
+    if (original_tokens.empty() || original_tokens != renamed_tokens) {
+        std::cerr << "Renamed copy produced a different token stream" << std::endl;
+        return 1;
+    }
+
+    TextNormalizer normalizer;
+    size_t sink = 0;
+    double normalize_ms = measure_ms([&] { sink += normalizer.normalize(original).size(); }, iterations);
+    double lexer_ms = measure_ms([&] {
+        sink += lexer.tokenize(original, SourceLexer::Language::Cpp).size();
+    }, iterations);
+
+    auto throughput = [&](double ms) { return corpus_mb / (ms / 1000.0); };
+
+    std::cout << "corpus: " << corpus_mb << " MB of C++, " << original_tokens.size() << " tokens" << std::endl;
+    std::cout << "TextNormalizer: " << normalize_ms << " ms (" << throughput(normalize_ms) << " MB/s)" << std::endl;
+    std::cout << "SourceLexer:    " << lexer_ms << " ms (" << throughput(lexer_ms) << " MB/s)" << std::endl;
+
+    return sink == 0 ? 1 : 0;
+}
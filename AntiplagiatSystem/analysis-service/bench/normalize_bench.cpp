@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include "text_normalizer.h"
+
+namespace {
+
+std::string legacy_normalize_text(const std::string& text) {
+    std::string result = text;
+
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    result.erase(std::unique(result.begin(), result.end(),
+        [](char a, char b) { return std::isspace(a) && std::isspace(b); }),
+        result.end());
+
+    return result;
+}
+
+std::string make_corpus(size_t size) {
+    static const char* words[] = {
+        "int", "Value", "return", "for", "(", ")", "{", "}", "std::vector<int>",
+        "Analyzer", "normalize_text", "while", "TOTAL", "+=", "i++", ";", "//",
+        "Plagiarism", "report", "const", "auto&", "if", "else"
+    };
+    static const char* gaps[] = {" ", " ", " ", "  ", "\n", "\n    ", "\t", "\r\n"};
+
+    std::mt19937 rng(42);
+    std::string corpus;
+    corpus.reserve(size + 64);
+    while (corpus.size() < size) {
+        corpus += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        corpus += gaps[rng() % (sizeof(gaps) / sizeof(gaps[0]))];
+    }
+    corpus.resize(size);
+    return corpus;
+}
+
+template <typename Fn>
+double measure_ms(Fn&& fn, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count() / iterations;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::string corpus = make_corpus(megabytes * 1024 * 1024);
+    TextNormalizer normalizer;
+
+    if (normalizer.normalize(corpus) != legacy_normalize_text(corpus)) {
+        std::cerr << "Kernel output differs from legacy normalize_text" << std::endl;
+        return 1;
+    }
+
+    size_t sink = 0;
+    double legacy_ms = measure_ms([&] { sink += legacy_normalize_text(corpus).size(); }, iterations);
+    double kernel_ms = measure_ms([&] { sink += normalizer.normalize(corpus).size(); }, iterations);
+    double tokens_ms = measure_ms([&] {
+        normalizer.normalize(corpus, true);
+        sink += normalizer.last_tokens().size();
+    }, iterations);
+
+    auto throughput = [&](double ms) { return megabytes / 1024.0 / (ms / 1000.0); };
+
+    std::cout << "corpus: " << megabytes << " MB, kernel: " << TextNormalizer::kernel_name() << std::endl;
+    std::cout << "legacy normalize_text:   " << legacy_ms << " ms (" << throughput(legacy_ms) << " GB/s)" << std::endl;
+    std::cout << "TextNormalizer:          " << kernel_ms << " ms (" << throughput(kernel_ms) << " GB/s)" << std::endl;
+    std::cout << "TextNormalizer + tokens: " << tokens_ms << " ms (" << throughput(tokens_ms) << " GB/s)" << std::endl;
+    std::cout << "speedup: " << legacy_ms / kernel_ms << "x" << std::endl;
+
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,60 @@
+#include "analysis_cache.h"
+
+namespace {
+std::string pair_key(const std::string& first, const std::string& second) {
+    std::string key;
+    key.reserve(first.size() + second.size() + 1);
+    key += first;
+    key += '\n';
+    key += second;
+    return key;
+}
+}
+
+AnalysisCache::AnalysisCache(size_t content_capacity, size_t document_capacity)
+    : fingerprints(content_capacity), documents(document_capacity),
+      spans(content_capacity), scorings(content_capacity) {}
+
+std::string AnalysisCache::content_key(const std::string& file_hash, SourceLexer::Language language) {
+    return file_hash + ':' + SourceLexer::language_name(language);
+}
+
+AnalysisCache::Fingerprints AnalysisCache::get_fingerprints(const std::string& content_key) {
+    Fingerprints value;
+    fingerprints.get(content_key, value);
+    return value;
+}
+
+void AnalysisCache::put_fingerprints(const std::string& content_key, Fingerprints value) {
+    fingerprints.put(content_key, std::move(value));
+}
+
+AnalysisCache::Document AnalysisCache::get_document(const std::string& content_key) {
+    Document value;
+    documents.get(content_key, value);
+    return value;
+}
+
+void AnalysisCache::put_document(const std::string& content_key, Document value) {
+    documents.put(content_key, std::move(value));
+}
+
+AnalysisCache::Spans AnalysisCache::get_spans(const std::string& source_key, const std::string& target_key) {
+    Spans value;
+    spans.get(pair_key(source_key, target_key), value);
+    return value;
+}
+
+void AnalysisCache::put_spans(const std::string& source_key, const std::string& target_key, Spans value) {
+    spans.put(pair_key(source_key, target_key), std::move(value));
+}
+
+bool AnalysisCache::get_scoring(const std::string& student_id, const std::string& assignment_id,
+                                Scoring& scoring) {
+    return scorings.get(pair_key(student_id, assignment_id), scoring);
+}
+
+void AnalysisCache::put_scoring(const std::string& student_id, const std::string& assignment_id,
+                                Scoring scoring) {
+    scorings.put(pair_key(student_id, assignment_id), std::move(scoring));
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "fingerprint_store.h"
+#include "match_aligner.h"
+#include "source_lexer.h"
+
+// Per-content results of the analysis pipeline. Fingerprints, alignment
+// documents and aligned spans depend only on the file bytes and the language
+// they were read as, so they are keyed by file_hash and survive repeated
+// POST /analyze calls and resubmissions that keep most files unchanged.
+// The last ranking of each student's work on an assignment is kept too, so
+// the next version is rescored from the fingerprint difference.
+class AnalysisCache {
+public:
+    using Fingerprints = std::shared_ptr<const std::vector<uint64_t>>;
+    using Document = std::shared_ptr<const MatchAligner::Document>;
+    using Spans = std::shared_ptr<const std::vector<MatchAligner::Span>>;
+
+    struct Scoring {
+        int work_id = 0;
+        Fingerprints fingerprints;
+        FingerprintStore::Scores scores;
+    };
+
+private:
+    template <typename Value>
+    class Lru {
+    private:
+        using Item = std::pair<std::string, Value>;
+
+        std::mutex mutex;
+        size_t capacity;
+        std::list<Item> order;
+        std::unordered_map<std::string, typename std::list<Item>::iterator> items;
+
+    public:
+        explicit Lru(size_t capacity) : capacity(capacity) {}
+
+        bool get(const std::string& key, Value& value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = items.find(key);
+            if (it == items.end()) {
+                return false;
+            }
+            order.splice(order.begin(), order, it->second);
+            value = it->second->second;
+            return true;
+        }
+
+        void put(const std::string& key, Value value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = items.find(key);
+            if (it != items.end()) {
+                it->second->second = std::move(value);
+                order.splice(order.begin(), order, it->second);
+                return;
+            }
+
+            order.emplace_front(key, std::move(value));
+            items[key] = order.begin();
+            if (items.size() > capacity) {
+                items.erase(order.back().first);
+                order.pop_back();
+            }
+        }
+    };
+
+    Lru<Fingerprints> fingerprints;
+    Lru<Document> documents;
+    Lru<Spans> spans;
+    Lru<Scoring> scorings;
+
+public:
+    AnalysisCache(size_t content_capacity = 4096, size_t document_capacity = 128);
+
+    static std::string content_key(const std::string& file_hash, SourceLexer::Language language);
+
+    Fingerprints get_fingerprints(const std::string& content_key);
+    void put_fingerprints(const std::string& content_key, Fingerprints value);
+
+    Document get_document(const std::string& content_key);
+    void put_document(const std::string& content_key, Document value);
+
+    Spans get_spans(const std::string& source_key, const std::string& target_key);
+    void put_spans(const std::string& source_key, const std::string& target_key, Spans value);
+
+    // Latest ranking of this student's work on the assignment, if any.
+    bool get_scoring(const std::string& student_id, const std::string& assignment_id, Scoring& scoring);
+    void put_scoring(const std::string& student_id, const std::string& assignment_id, Scoring scoring);
+};
@@ -1,20 +1,55 @@
 #include "analyzer.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <algorithm>
-#include <cctype>
+#include <unordered_map>
 #include <cpprest/http_client.h>
+#include "text_normalizer.h"
 
 using namespace web::http;
 using namespace web::http::client;
 
+namespace {
+const double SIMILARITY_THRESHOLD = 50.0;
+const double DEFAULT_CLUSTER_THRESHOLD = 0.5;
+
+// Source code is winnowed over lexer tokens: a shared run of 12 + 8 - 1
+// tokens, roughly two statements, always yields a common fingerprint.
+const size_t TOKEN_GRAM = 12;
+const size_t TOKEN_WINDOW = 8;
+
+// Flagged works are aligned against their best few candidates to show the
+// matching regions; spans shorter than a winnowing guarantee are noise.
+const size_t ALIGN_CANDIDATES = 3;
+const double ALIGN_MIN_SIMILARITY = 25.0;
+const size_t ALIGN_MIN_WORDS = 8;
+const size_t ALIGN_MIN_TOKENS = TOKEN_GRAM;
+const size_t ALIGN_MAX_SPANS = 100;
+// Clients reach the service through the gateway, which serves jobs here.
+const char JOB_STATUS_PREFIX[] = "/api/jobs/";
+
+json::value region_json(const MatchAligner::Region& region) {
+    json::value result;
+    result[U("begin")] = json::value::number(region.begin);
+    result[U("end")] = json::value::number(region.end);
+    result[U("first_line")] = json::value::number(region.first_line);
+    result[U("last_line")] = json::value::number(region.last_line);
+    return result;
+}
+}
+
 Analyzer::Analyzer(const std::string& url, const std::string& db_conn_str,
-                   const std::string& file_service_url)
-    : listener(url), file_service_url(file_service_url) {
+                   const std::string& file_service_url, const std::string& index_path,
+                   const std::string& upload_dir, size_t worker_count, size_t queue_capacity,
+                   size_t report_batch_size, size_t report_batch_delay_ms)
+    : listener(url), file_service_url(file_service_url), blob_store(upload_dir),
+      token_fingerprinter(TOKEN_GRAM, TOKEN_WINDOW), fingerprint_store(index_path) {
     
     try {
-        db = std::make_unique<Database>(db_conn_str);
+        // One connection per analysis worker plus a few for request handlers.
+        db = std::make_unique<Database>(db_conn_str, worker_count + 4);
+        fingerprint_store.load(*db);
+        report_writer = std::make_unique<ReportWriter>(
+            *db, report_batch_size, std::chrono::milliseconds(report_batch_delay_ms));
+        job_queue = std::make_unique<JobQueue>(worker_count, queue_capacity);
 
         listener.support(methods::GET, [this](http_request request) {
             auto path = request.relative_uri().path();
@@ -23,6 +58,8 @@ Analyzer::Analyzer(const std::string& url, const std::string& db_conn_str,
                 handle_health(request);
             } else if (path.find(U("/reports/")) == 0) {
                 handle_get_report(request);
+            } else if (path.find(U("/jobs/")) == 0) {
+                handle_get_job(request);
             } else {
                 send_error_response(request, status_codes::NotFound,
                     "not_found", "Endpoint not found");
@@ -34,6 +71,8 @@ Analyzer::Analyzer(const std::string& url, const std::string& db_conn_str,
             
             if (path == U("/analyze")) {
                 handle_analyze(request);
+            } else if (path.find(U("/analyze/assignment/")) == 0) {
+                handle_analyze_assignment(request);
             } else {
                 send_error_response(request, status_codes::NotFound,
                     "not_found", "Endpoint not found");
@@ -68,6 +107,14 @@ void Analyzer::start() {
 
 void Analyzer::stop() {
     listener.close().wait();
+    if (job_queue) {
+        job_queue->stop();
+    }
+    // After the workers: jobs still running wait on their reports.
+    if (report_writer) {
+        report_writer->stop();
+    }
+    fingerprint_store.save_index();
     std::cout << "[ANALYSIS SERVICE] Stopped" << std::endl;
 }
 
@@ -76,6 +123,10 @@ void Analyzer::handle_health(http_request request) {
     response[U("service")] = json::value::string(U("analysis-service"));
     response[U("status")] = json::value::string(U("healthy"));
     response[U("database")] = json::value::boolean(db->is_connected());
+    response[U("queued_jobs")] = json::value::number(job_queue->queued());
+    response[U("workers")] = json::value::number(job_queue->worker_count());
+    response[U("pending_reports")] = json::value::number(static_cast<uint64_t>(report_writer->pending()));
+    response[U("cached_works")] = json::value::number(static_cast<uint64_t>(db->cached_works()));
     response[U("file_service")] = json::value::string(
         utility::conversions::to_string_t(file_service_url));
     response[U("timestamp")] = json::value::string(
@@ -88,72 +139,279 @@ void Analyzer::handle_health(http_request request) {
 }
 
 void Analyzer::handle_analyze(http_request request) {
-    try {
-        request.extract_json().then([this, request](pplx::task<json::value> task) {
-            try {
-                auto data = task.get();
-                
-                if (!data.has_field(U("work_id"))) {
-                    send_error_response(request, status_codes::BadRequest,
-                        "missing_field", "work_id is required");
-                    return;
-                }
-                
-                int work_id = data[U("work_id")].as_integer();
-                std::cout << "[ANALYSIS] Starting analysis for work ID: " << work_id << std::endl;
-
-                auto work_info = db->get_work_info(work_id);
-
-                Database::SimilarWork match;
-                bool plagiarism_found = check_plagiarism_simple(
-                    work_info.file_hash, work_info.student_id, match);
-                
-                double similarity = 0.0;
-                if (plagiarism_found) {
-                    similarity = 100.0; 
-                }
+    request.extract_json().then([this, request](pplx::task<json::value> task) {
+        int work_id = 0;
+        try {
+            auto data = task.get();
 
-                auto report_json = create_report_json(plagiarism_found, similarity, match);
-                std::string report_str = utility::conversions::to_utf8string(
-                    report_json.serialize());
-
-                std::string matched_name = plagiarism_found ? match.student_name : "";
-                int matched_id = plagiarism_found ? match.id : -1;
-                
-                db->save_report(work_id, plagiarism_found, similarity,
-                               matched_id, matched_name, report_str);
-
-                json::value response;
-                response[U("success")] = json::value::boolean(true);
-                response[U("work_id")] = json::value::number(work_id);
-                response[U("plagiarism_found")] = json::value::boolean(plagiarism_found);
-                response[U("similarity_percentage")] = json::value::number(similarity);
-                
-                if (plagiarism_found) {
-                    response[U("matched_work_id")] = json::value::number(match.id);
-                    response[U("matched_student_name")] = json::value::string(
-                        utility::conversions::to_string_t(match.student_name));
-                }
-                
-                response[U("message")] = json::value::string(
-                    plagiarism_found ? 
-                    U("Plagiarism detected") : 
-                    U("No plagiarism detected"));
-                
-                send_json_response(request, status_codes::OK, response);
-                
-            } catch (const std::exception& e) {
-                std::cerr << "[ANALYSIS SERVICE ERROR] Analyze: " << e.what() << std::endl;
-                send_error_response(request, status_codes::InternalError,
-                    "analysis_error", e.what());
+            if (!data.has_field(U("work_id"))) {
+                send_error_response(request, status_codes::BadRequest,
+                    "missing_field", "work_id is required");
+                return;
             }
-        }).wait();
-        
+
+            work_id = data[U("work_id")].as_integer();
+        } catch (const std::exception& e) {
+            std::cerr << "[ANALYSIS SERVICE ERROR] Analyze request: " << e.what() << std::endl;
+            send_error_response(request, status_codes::BadRequest,
+                "invalid_request", "Invalid request format");
+            return;
+        }
+
+        std::string job_id;
+        if (!job_queue->submit(work_id, [this, work_id] { return run_analysis(work_id); }, job_id)) {
+            send_queue_full_response(request);
+            return;
+        }
+
+        std::cout << "[ANALYSIS] Queued work ID " << work_id << " as job " << job_id << std::endl;
+
+        json::value response;
+        response[U("success")] = json::value::boolean(true);
+        response[U("job_id")] = json::value::string(utility::conversions::to_string_t(job_id));
+        response[U("work_id")] = json::value::number(work_id);
+        response[U("status")] = json::value::string(U("queued"));
+        response[U("status_url")] = json::value::string(
+            utility::conversions::to_string_t(JOB_STATUS_PREFIX + job_id));
+
+        send_json_response(request, status_codes::Accepted, response);
+    });
+}
+
+json::value Analyzer::run_analysis(int work_id) {
+    std::cout << "[ANALYSIS] Starting analysis for work ID: " << work_id << std::endl;
+
+    auto work_info = db->get_work_info(work_id);
+
+    AnalysisCache::Fingerprints fingerprints;
+    try {
+        fingerprints = fingerprint_work(work_info);
     } catch (const std::exception& e) {
-        std::cerr << "[ANALYSIS SERVICE ERROR] Analyze request: " << e.what() << std::endl;
+        std::cerr << "[ANALYSIS] Fingerprinting skipped for work ID " << work_id
+                  << ": " << e.what() << std::endl;
+    }
+
+    Database::SimilarWork match;
+    std::string algorithm = "simple_hash_comparison";
+    bool plagiarism_found = check_plagiarism_simple(
+        work_info.file_hash, work_info.student_id, match);
+    
+    double similarity = 0.0;
+    std::vector<FingerprintStore::Match> candidates;
+    if (plagiarism_found) {
+        similarity = 100.0; 
+        candidates.push_back({match, similarity});
+    } else if (fingerprints && !fingerprints->empty()) {
+        algorithm = SourceLexer::detect_language(work_info.original_filename) == SourceLexer::Language::Text
+            ? "winnowing" : "token_winnowing";
+        candidates = rank_candidates(work_info, fingerprints);
+        if (!candidates.empty()) {
+            match = candidates[0].work;
+            similarity = candidates[0].similarity;
+        }
+        plagiarism_found = similarity >= SIMILARITY_THRESHOLD;
+    }
+
+    json::value regions = plagiarism_found ? match_regions(work_info, candidates) : json::value::array();
+    auto report_json = create_report_json(plagiarism_found, similarity, match, algorithm, regions);
+    std::string report_str = utility::conversions::to_utf8string(
+        report_json.serialize());
+
+    std::string matched_name = plagiarism_found ? match.student_name : "";
+    int matched_id = plagiarism_found ? match.id : -1;
+    
+    // Reports are group-committed with those of other workers; the job is
+    // reported complete only once its report is stored.
+    report_writer->submit({work_id, plagiarism_found, similarity,
+                           matched_id, matched_name, std::move(report_str)}).get();
+
+    json::value response;
+    response[U("success")] = json::value::boolean(true);
+    response[U("work_id")] = json::value::number(work_id);
+    response[U("plagiarism_found")] = json::value::boolean(plagiarism_found);
+    response[U("similarity_percentage")] = json::value::number(similarity);
+    
+    if (plagiarism_found) {
+        response[U("matched_work_id")] = json::value::number(match.id);
+        response[U("matched_student_name")] = json::value::string(
+            utility::conversions::to_string_t(match.student_name));
+    }
+    
+    response[U("message")] = json::value::string(
+        plagiarism_found ? 
+        U("Plagiarism detected") : 
+        U("No plagiarism detected"));
+
+    return response;
+}
+
+void Analyzer::handle_get_job(http_request request) {
+    auto path = request.relative_uri().path();
+    std::string path_str = utility::conversions::to_utf8string(path);
+    std::string job_id = path_str.substr(path_str.find_last_of('/') + 1);
+
+    JobQueue::JobInfo job;
+    if (!job_queue->get(job_id, job)) {
+        send_error_response(request, status_codes::NotFound,
+            "job_not_found", "Job not found or expired");
+        return;
+    }
+
+    json::value response;
+    response[U("job_id")] = json::value::string(utility::conversions::to_string_t(job.id));
+    if (job.work_id != 0) {
+        response[U("work_id")] = json::value::number(job.work_id);
+    }
+    response[U("status")] = json::value::string(
+        utility::conversions::to_string_t(JobQueue::status_name(job.status)));
+    response[U("created_at")] = json::value::number(static_cast<int64_t>(job.created_at));
+
+    if (job.status == JobQueue::Status::Completed) {
+        response[U("result")] = job.result;
+    } else if (job.status == JobQueue::Status::Failed) {
+        response[U("error")] = json::value::string(utility::conversions::to_string_t(job.error));
+    }
+    if (job.finished_at != 0) {
+        response[U("finished_at")] = json::value::number(static_cast<int64_t>(job.finished_at));
+    }
+
+    send_json_response(request, status_codes::OK, response);
+}
+
+void Analyzer::handle_analyze_assignment(http_request request) {
+    auto path = request.relative_uri().path();
+    std::string path_str = utility::conversions::to_utf8string(path);
+
+    size_t pos = path_str.find_last_of('/');
+    std::string assignment_id = pos == std::string::npos ? "" : path_str.substr(pos + 1);
+    if (assignment_id.empty()) {
         send_error_response(request, status_codes::BadRequest,
-            "invalid_request", "Invalid request format");
+            "invalid_path", "assignment id is required");
+        return;
+    }
+
+    double threshold = DEFAULT_CLUSTER_THRESHOLD;
+    auto query = uri::split_query(request.request_uri().query());
+    auto threshold_param = query.find(U("threshold"));
+    if (threshold_param != query.end()) {
+        std::string value = utility::conversions::to_utf8string(threshold_param->second);
+        size_t parsed = 0;
+        try {
+            threshold = std::stod(value, &parsed);
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != value.size() || !(threshold > 0.0 && threshold <= 1.0)) {
+            send_error_response(request, status_codes::BadRequest,
+                "invalid_threshold", "threshold must be a number in (0, 1]");
+            return;
+        }
+    }
+
+    // Fingerprinting the works not seen yet means reading every file, so the
+    // clustering runs on the worker pool like single analyses.
+    std::string job_id;
+    if (!job_queue->submit(0, [this, assignment_id, threshold] {
+            return cluster_assignment(assignment_id, threshold);
+        }, job_id)) {
+        send_queue_full_response(request);
+        return;
+    }
+
+    std::cout << "[ANALYSIS] Queued clustering of assignment " << assignment_id
+              << " as job " << job_id << std::endl;
+
+    json::value response;
+    response[U("success")] = json::value::boolean(true);
+    response[U("job_id")] = json::value::string(utility::conversions::to_string_t(job_id));
+    response[U("assignment_id")] = json::value::string(utility::conversions::to_string_t(assignment_id));
+    response[U("status")] = json::value::string(U("queued"));
+    response[U("status_url")] = json::value::string(
+        utility::conversions::to_string_t(JOB_STATUS_PREFIX + job_id));
+
+    send_json_response(request, status_codes::Accepted, response);
+}
+
+json::value Analyzer::cluster_assignment(const std::string& assignment_id, double threshold) {
+    std::cout << "[ANALYSIS] Clustering assignment: " << assignment_id << std::endl;
+
+    auto works = db->get_works_by_assignment(assignment_id);
+    size_t skipped = 0;
+    for (const auto& work : works) {
+        if (fingerprint_store.contains(work.id)) {
+            continue;
+        }
+        try {
+            fingerprint_work(work);
+        } catch (const std::exception& e) {
+            std::cerr << "[ANALYSIS] Fingerprinting skipped for work ID " << work.id
+                      << ": " << e.what() << std::endl;
+            skipped++;
+        }
+    }
+
+    auto signed_works = fingerprint_store.assignment_signatures(assignment_id, minhasher);
+
+    std::vector<LshClusterer::Item> items;
+    std::unordered_map<int, const FingerprintStore::SignedWork*> by_id;
+    items.reserve(signed_works.size());
+    for (const auto& work : signed_works) {
+        items.push_back({work.work_id, work.student_id, &work.signature});
+        by_id[work.work_id] = &work;
+    }
+
+    bool truncated = false;
+    auto clusters = lsh.cluster(items, threshold, &truncated);
+    if (truncated) {
+        std::cerr << "[ANALYSIS] Clustering of assignment " << assignment_id
+                  << " hit the comparison limit; some pairs were not compared" << std::endl;
+    }
+
+    json::value clusters_json = json::value::array();
+    size_t cluster_index = 0;
+    for (const auto& cluster : clusters) {
+        json::value cluster_json;
+
+        json::value members = json::value::array();
+        size_t member_index = 0;
+        for (int work_id : cluster.work_ids) {
+            const auto& work = *by_id.at(work_id);
+            json::value member;
+            member[U("work_id")] = json::value::number(work_id);
+            member[U("student_id")] = json::value::string(
+                utility::conversions::to_string_t(work.student_id));
+            member[U("student_name")] = json::value::string(
+                utility::conversions::to_string_t(work.student_name));
+            members[member_index++] = member;
+        }
+
+        json::value pairs = json::value::array();
+        size_t pair_index = 0;
+        for (const auto& pair : cluster.pairs) {
+            json::value pair_json;
+            pair_json[U("work_id_a")] = json::value::number(pair.work_a);
+            pair_json[U("work_id_b")] = json::value::number(pair.work_b);
+            pair_json[U("estimated_jaccard")] = json::value::number(pair.jaccard);
+            pairs[pair_index++] = pair_json;
+        }
+
+        cluster_json[U("works")] = members;
+        cluster_json[U("pairs")] = pairs;
+        clusters_json[cluster_index++] = cluster_json;
     }
+
+    json::value response;
+    response[U("assignment_id")] = json::value::string(
+        utility::conversions::to_string_t(assignment_id));
+    response[U("works_count")] = json::value::number(works.size());
+    response[U("analyzed_count")] = json::value::number(signed_works.size());
+    response[U("skipped_count")] = json::value::number(skipped);
+    response[U("threshold")] = json::value::number(threshold);
+    response[U("algorithm_used")] = json::value::string(U("minhash_lsh"));
+    response[U("truncated")] = json::value::boolean(truncated);
+    response[U("clusters")] = clusters_json;
+
+    return response;
 }
 
 void Analyzer::handle_get_report(http_request request) {
@@ -170,22 +428,24 @@ void Analyzer::handle_get_report(http_request request) {
         
         int work_id = std::stoi(path_str.substr(pos + 1));
 
-        if (!db->report_exists(work_id)) {
+        std::string report_json;
+        if (!db->fetch_report(work_id, report_json)) {
             send_error_response(request, status_codes::NotFound,
                 "report_not_found", "Report not found for this work");
             return;
         }
 
-        std::string report_json = db->get_report(work_id);
-
-        json::value report = json::value::parse(
-            utility::conversions::to_string_t(report_json));
-        
-        json::value response;
-        response[U("work_id")] = json::value::number(work_id);
-        response[U("report")] = report;
+        // report_data is already valid JSON, so it is spliced in verbatim
+        // instead of being parsed and serialized again.
+        std::string body;
+        body.reserve(report_json.size() + 32);
+        body += "{\"work_id\":";
+        body += std::to_string(work_id);
+        body += ",\"report\":";
+        body += report_json;
+        body += '}';
         
-        send_json_response(request, status_codes::OK, response);
+        send_raw_json_response(request, status_codes::OK, std::move(body));
         
     } catch (const std::exception& e) {
         std::cerr << "[ANALYSIS SERVICE ERROR] Get report: " << e.what() << std::endl;
@@ -207,24 +467,78 @@ bool Analyzer::check_plagiarism_simple(const std::string& file_hash,
     return false;
 }
 
+AnalysisCache::Fingerprints Analyzer::fingerprint_work(const Database::WorkInfo& work_info) {
+    auto language = SourceLexer::detect_language(work_info.original_filename);
+    auto key = AnalysisCache::content_key(work_info.file_hash, language);
+
+    auto fingerprints = analysis_cache.get_fingerprints(key);
+    if (fingerprints && fingerprint_store.contains(work_info.id, work_info.file_hash)) {
+        return fingerprints;
+    }
+
+    if (!fingerprints) {
+        auto content = read_file_content(resolve_work_path(work_info));
+
+        // Source files are compared by token stream, so renamed identifiers and
+        // edited comments don't hide a copy; anything else by normalized text.
+        fingerprints = std::make_shared<const std::vector<uint64_t>>(language == SourceLexer::Language::Text
+            ? fingerprinter.fingerprint(normalize_text(content->view()))
+            : token_fingerprinter.fingerprint(lex_source(content->view(), language)));
+        analysis_cache.put_fingerprints(key, fingerprints);
+    }
+
+    db->save_fingerprints(work_info.id, Fingerprinter::encode(*fingerprints));
+
+    FingerprintStore::Entry entry;
+    entry.work_id = work_info.id;
+    entry.student_id = work_info.student_id;
+    entry.student_name = work_info.student_name;
+    entry.assignment_id = work_info.assignment_id;
+    entry.file_hash = work_info.file_hash;
+    entry.fingerprints = *fingerprints;
+    fingerprint_store.put(std::move(entry));
+
+    return fingerprints;
+}
+
+std::vector<FingerprintStore::Match> Analyzer::rank_candidates(const Database::WorkInfo& work_info,
+                                                               const AnalysisCache::Fingerprints& fingerprints) {
+    // A resubmission (or a repeated analysis) starts from the ranking of the
+    // student's previous version and only recounts what the edit touched.
+    AnalysisCache::Scoring previous;
+    AnalysisCache::Scoring current;
+    current.work_id = work_info.id;
+    current.fingerprints = fingerprints;
+
+    std::vector<FingerprintStore::Match> candidates;
+    if (analysis_cache.get_scoring(work_info.student_id, work_info.assignment_id, previous)) {
+        candidates = fingerprint_store.rescore_matches(*fingerprints, *previous.fingerprints, previous.scores,
+            work_info.id, work_info.student_id, ALIGN_CANDIDATES, current.scores);
+        std::cout << "[ANALYSIS] Work ID " << work_info.id << " rescored from work ID "
+                  << previous.work_id << std::endl;
+    } else {
+        candidates = fingerprint_store.find_matches(*fingerprints, work_info.id, work_info.student_id,
+            ALIGN_CANDIDATES, &current.scores);
+    }
+
+    analysis_cache.put_scoring(work_info.student_id, work_info.assignment_id, std::move(current));
+    return candidates;
+}
+
 double Analyzer::calculate_similarity(const std::string& filepath1, 
                                      const std::string& filepath2) {
     try {
-        std::string content1 = read_file_content(filepath1);
-        std::string content2 = read_file_content(filepath2);
+        auto content1 = read_file_content(filepath1);
+        auto content2 = read_file_content(filepath2);
         
-        if (content1.empty() || content2.empty()) {
+        if (content1->empty() || content2->empty()) {
             return 0.0;
         }
 
-        std::string normalized1 = normalize_text(content1);
-        std::string normalized2 = normalize_text(content2);
+        auto fingerprints1 = fingerprinter.fingerprint(normalize_text(content1->view()));
+        auto fingerprints2 = fingerprinter.fingerprint(normalize_text(content2->view()));
         
-        if (normalized1 == normalized2) {
-            return 100.0;
-        }
-        
-        return 0.0;
+        return Fingerprinter::similarity(fingerprints1, fingerprints2);
         
     } catch (const std::exception& e) {
         std::cerr << "[ANALYSIS ERROR] calculate_similarity: " << e.what() << std::endl;
@@ -232,32 +546,114 @@ double Analyzer::calculate_similarity(const std::string& filepath1,
     }
 }
 
-std::string Analyzer::read_file_content(const std::string& filepath) {
-    std::ifstream file(filepath);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + filepath);
+std::string Analyzer::resolve_work_path(const Database::WorkInfo& work_info) {
+    if (blob_store.exists(work_info.file_hash)) {
+        return blob_store.path_for(work_info.file_hash);
     }
-    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return work_info.file_path;
+}
+
+std::shared_ptr<MappedFile> Analyzer::read_file_content(const std::string& filepath) {
+    return MappedFile::open(filepath);
 }
 
-std::string Analyzer::normalize_text(const std::string& text) {
-    std::string result = text;
+const std::string& Analyzer::normalize_text(std::string_view text) {
+    thread_local TextNormalizer normalizer;
+    return normalizer.normalize(text.data(), text.size());
+}
 
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
+const std::vector<uint16_t>& Analyzer::lex_source(std::string_view text, SourceLexer::Language language) {
+    thread_local SourceLexer lexer;
+    return lexer.tokenize(text.data(), text.size(), language);
+}
 
-    result.erase(std::unique(result.begin(), result.end(),
-        [](char a, char b) { return std::isspace(a) && std::isspace(b); }),
-        result.end());
-    
-    return result;
+AnalysisCache::Document Analyzer::alignment_document(const Database::WorkInfo& work_info,
+                                                     SourceLexer::Language language) {
+    auto key = AnalysisCache::content_key(work_info.file_hash, language);
+    auto document = analysis_cache.get_document(key);
+    if (document) {
+        return document;
+    }
+
+    auto content = read_file_content(resolve_work_path(work_info));
+    if (language == SourceLexer::Language::Text) {
+        document = std::make_shared<const MatchAligner::Document>(
+            MatchAligner::Document::from_words(content->view()));
+    } else {
+        SourceLexer lexer;
+        const auto& tokens = lexer.tokenize(content->data(), content->size(), language, true);
+        document = std::make_shared<const MatchAligner::Document>(
+            MatchAligner::Document::from_tokens(content->view(), tokens, lexer.last_positions()));
+    }
+
+    analysis_cache.put_document(key, document);
+    return document;
+}
+
+json::value Analyzer::match_regions(const Database::WorkInfo& work_info,
+                                    const std::vector<FingerprintStore::Match>& matches) {
+    json::value regions = json::value::array();
+    auto language = SourceLexer::detect_language(work_info.original_filename);
+    bool tokens = language != SourceLexer::Language::Text;
+
+    try {
+        auto source_key = AnalysisCache::content_key(work_info.file_hash, language);
+        AnalysisCache::Document source;
+
+        size_t index = 0;
+        for (const auto& candidate : matches) {
+            if (candidate.similarity < ALIGN_MIN_SIMILARITY) {
+                continue;
+            }
+
+            auto other = db->get_work_info(candidate.work.id);
+            if (SourceLexer::detect_language(other.original_filename) != language) {
+                continue;
+            }
+
+            auto target_key = AnalysisCache::content_key(other.file_hash, language);
+            auto spans = analysis_cache.get_spans(source_key, target_key);
+            if (!spans) {
+                if (!source) {
+                    source = alignment_document(work_info, language);
+                }
+                spans = std::make_shared<const std::vector<MatchAligner::Span>>(MatchAligner::align(
+                    *source, *alignment_document(other, language),
+                    tokens ? ALIGN_MIN_TOKENS : ALIGN_MIN_WORDS, ALIGN_MAX_SPANS));
+                analysis_cache.put_spans(source_key, target_key, spans);
+            }
+
+            json::value spans_json = json::value::array();
+            for (size_t i = 0; i < spans->size(); ++i) {
+                const auto& found = (*spans)[i];
+                json::value span;
+                span[U("length")] = json::value::number(found.length);
+                span[U("source")] = region_json(found.source);
+                span[U("target")] = region_json(found.target);
+                spans_json[i] = span;
+            }
+
+            json::value region;
+            region[U("work_id")] = json::value::number(candidate.work.id);
+            region[U("student_name")] = json::value::string(
+                utility::conversions::to_string_t(candidate.work.student_name));
+            region[U("similarity_percentage")] = json::value::number(candidate.similarity);
+            region[U("unit")] = json::value::string(tokens ? U("tokens") : U("words"));
+            region[U("spans")] = spans_json;
+            regions[index++] = region;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ANALYSIS] Match alignment skipped for work ID " << work_info.id
+                  << ": " << e.what() << std::endl;
+    }
+
+    return regions;
 }
 
 json::value Analyzer::create_report_json(bool plagiarism_found, double similarity,
-                                        const Database::SimilarWork& match) {
+                                        const Database::SimilarWork& match,
+                                        const std::string& algorithm,
+                                        const json::value& matched_regions) {
     json::value report;
     report[U("analysis_timestamp")] = json::value::string(
         utility::conversions::to_string_t(
@@ -276,7 +672,12 @@ json::value Analyzer::create_report_json(bool plagiarism_found, double similarit
             utility::conversions::to_string_t(match.file_hash));
     }
     
-    report[U("algorithm_used")] = json::value::string(U("simple_hash_comparison"));
+    if (matched_regions.size() > 0) {
+        report[U("matched_regions")] = matched_regions;
+    }
+    
+    report[U("algorithm_used")] = json::value::string(
+        utility::conversions::to_string_t(algorithm));
     
     return report;
 }
@@ -297,10 +698,29 @@ void Analyzer::send_json_response(http_request request, status_code status, cons
     request.reply(response);
 }
 
+void Analyzer::send_raw_json_response(http_request request, status_code status, std::string body) {
+    http_response response(status);
+    response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
+    response.set_body(std::move(body), "application/json");
+    request.reply(response);
+}
+
 void Analyzer::send_error_response(http_request request, status_code status,
                                   const std::string& error, const std::string& message) {
     json::value response;
     response[U("error")] = json::value::string(utility::conversions::to_string_t(error));
     response[U("message")] = json::value::string(utility::conversions::to_string_t(message));
     send_json_response(request, status, response);
+}
+
+void Analyzer::send_queue_full_response(http_request request) {
+    json::value body;
+    body[U("error")] = json::value::string(U("queue_full"));
+    body[U("message")] = json::value::string(U("Analysis queue is full, retry later"));
+
+    http_response response(status_codes::ServiceUnavailable);
+    response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
+    response.headers().add(U("Retry-After"), U("5"));
+    response.set_body(body);
+    request.reply(response);
 }
\ No newline at end of file
@@ -2,8 +2,19 @@
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
 #include <string>
+#include <string_view>
 #include <memory>
 #include "database.h"
+#include "mapped_file.h"
+#include "blob_store.h"
+#include "fingerprint.h"
+#include "fingerprint_store.h"
+#include "source_lexer.h"
+#include "match_aligner.h"
+#include "analysis_cache.h"
+#include "minhash.h"
+#include "job_queue.h"
+#include "report_writer.h"
 
 using namespace web;
 using namespace web::http;
@@ -14,10 +25,21 @@ private:
     http_listener listener;
     std::unique_ptr<Database> db;
     std::string file_service_url;
+    BlobStore blob_store;
+    Fingerprinter fingerprinter;
+    Fingerprinter token_fingerprinter;
+    FingerprintStore fingerprint_store;
+    MinHasher minhasher;
+    LshClusterer lsh;
+    AnalysisCache analysis_cache;
+    std::unique_ptr<JobQueue> job_queue;
+    std::unique_ptr<ReportWriter> report_writer;
     
 public:
     Analyzer(const std::string& url, const std::string& db_conn_str, 
-             const std::string& file_service_url);
+             const std::string& file_service_url, const std::string& index_path,
+             const std::string& upload_dir, size_t worker_count, size_t queue_capacity,
+             size_t report_batch_size, size_t report_batch_delay_ms);
     ~Analyzer();
     
     void start();
@@ -26,6 +48,8 @@ public:
 private:
     void handle_health(http_request request);
     void handle_analyze(http_request request);
+    void handle_analyze_assignment(http_request request);
+    void handle_get_job(http_request request);
     void handle_get_report(http_request request);
     void handle_options(http_request request);
 
@@ -36,13 +60,30 @@ private:
     double calculate_similarity(const std::string& filepath1, 
                                 const std::string& filepath2);
     
-    std::string read_file_content(const std::string& filepath);
-    std::string normalize_text(const std::string& text);
+    json::value run_analysis(int work_id);
+    json::value cluster_assignment(const std::string& assignment_id, double threshold);
+    AnalysisCache::Fingerprints fingerprint_work(const Database::WorkInfo& work_info);
+    std::vector<FingerprintStore::Match> rank_candidates(const Database::WorkInfo& work_info,
+                                                         const AnalysisCache::Fingerprints& fingerprints);
+
+    std::string resolve_work_path(const Database::WorkInfo& work_info);
+    std::shared_ptr<MappedFile> read_file_content(const std::string& filepath);
+    const std::string& normalize_text(std::string_view text);
+    const std::vector<uint16_t>& lex_source(std::string_view text, SourceLexer::Language language);
+
+    AnalysisCache::Document alignment_document(const Database::WorkInfo& work_info,
+                                               SourceLexer::Language language);
+    json::value match_regions(const Database::WorkInfo& work_info,
+                              const std::vector<FingerprintStore::Match>& matches);
 
     void send_json_response(http_request request, status_code status, const json::value& body);
+    void send_raw_json_response(http_request request, status_code status, std::string body);
     void send_error_response(http_request request, status_code status, 
                             const std::string& error, const std::string& message);
+    void send_queue_full_response(http_request request);
     
     json::value create_report_json(bool plagiarism_found, double similarity,
-                                  const Database::SimilarWork& match);
+                                  const Database::SimilarWork& match,
+                                  const std::string& algorithm,
+                                  const json::value& matched_regions);
 };
\ No newline at end of file
@@ -1,14 +1,42 @@
 #include "database.h"
 #include <iostream>
+#include <unordered_map>
+#include "work_cache.h"
 
-Database::Database(const std::string& connection_string) {
+namespace {
+// Works rows change only on upload (file service) and on status updates
+// made here; the TTL bounds how long a cross-service change stays unseen.
+const size_t WORK_CACHE_CAPACITY = 16384;
+const std::chrono::milliseconds WORK_CACHE_TTL(60000);
+const size_t WORK_CACHE_SHARDS = 16;
+
+Database::WorkInfo read_work_info(const pqxx::row& row) {
+    Database::WorkInfo info;
+    info.id = row["id"].as<int>();
+    info.student_id = row["student_id"].as<std::string>();
+    info.student_name = row["student_name"].as<std::string>();
+    info.assignment_id = row["assignment_id"].as<std::string>();
+    info.file_path = row["file_path"].as<std::string>();
+    info.original_filename = row["original_filename"].as<std::string>();
+    info.file_hash = row["file_hash"].as<std::string>();
+    info.status = row["status"].as<std::string>();
+    return info;
+}
+}
+
+Database::Database(const std::string& connection_string, size_t pool_size) {
     try {
-        conn = std::make_unique<pqxx::connection>(connection_string);
-        if (conn->is_open()) {
-            std::cout << "[ANALYSIS DB] Connected to PostgreSQL successfully" << std::endl;
-        } else {
-            throw std::runtime_error("Cannot open database connection");
+        {
+            pqxx::connection bootstrap(connection_string);
+            if (!bootstrap.is_open()) {
+                throw std::runtime_error("Cannot open database connection");
+            }
+            create_tables(bootstrap);
         }
+
+        pool = std::make_unique<ConnectionPool>(connection_string, pool_size, &Database::prepare_statements);
+        work_cache = std::make_unique<WorkCache>(WORK_CACHE_CAPACITY, WORK_CACHE_TTL, WORK_CACHE_SHARDS);
+        std::cout << "[ANALYSIS DB] Connected to PostgreSQL successfully (pool size " << pool_size << ")" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "[ANALYSIS DB ERROR] " << e.what() << std::endl;
         throw;
@@ -16,38 +44,78 @@ Database::Database(const std::string& connection_string) {
 }
 
 Database::~Database() {
-    if (conn && conn->is_open()) {
-        conn->close();
-        std::cout << "[ANALYSIS DB] Connection closed" << std::endl;
-    }
+    pool.reset();
+    std::cout << "[ANALYSIS DB] Connections closed" << std::endl;
 }
 
 bool Database::is_connected() const {
-    return conn && conn->is_open();
+    return pool && pool->healthy();
+}
+
+size_t Database::cached_works() const {
+    return work_cache ? work_cache->size() : 0;
+}
+
+void Database::prepare_statements(pqxx::connection& conn) {
+    conn.prepare("get_work_info",
+                 "SELECT id, student_id, student_name, assignment_id, file_path, original_filename, "
+                 "file_hash, status "
+                 "FROM works WHERE id = $1");
+    conn.prepare("get_works_by_assignment",
+                 "SELECT id, student_id, student_name, assignment_id, file_path, original_filename, "
+                 "file_hash, status "
+                 "FROM works WHERE assignment_id = $1 ORDER BY id");
+    conn.prepare("get_work_by_hash",
+                 "SELECT id, student_id, student_name, assignment_id, file_path, original_filename, "
+                 "file_hash, status "
+                 "FROM works WHERE file_hash = $1");
+    conn.prepare("update_work_status", "UPDATE works SET status = $1 WHERE id = $2");
+    conn.prepare("fetch_report",
+                 "SELECT COALESCE(report_data::text, '{}') AS report FROM reports WHERE work_id = $1");
+    conn.prepare("save_fingerprints",
+                 "INSERT INTO work_fingerprints (work_id, fingerprints) VALUES ($1, $2) "
+                 "ON CONFLICT (work_id) DO UPDATE SET fingerprints = EXCLUDED.fingerprints, "
+                 "updated_at = CURRENT_TIMESTAMP");
+    conn.prepare("load_fingerprints",
+                 "SELECT w.id, w.student_id, w.student_name, w.assignment_id, w.file_hash, "
+                 "f.fingerprints FROM work_fingerprints f JOIN works w ON f.work_id = w.id");
+}
+
+void Database::create_tables(pqxx::connection& conn) {
+    try {
+        pqxx::work txn(conn);
+
+        txn.exec("CREATE TABLE IF NOT EXISTS work_fingerprints ("
+                 "work_id INTEGER PRIMARY KEY REFERENCES works(id) ON DELETE CASCADE,"
+                 "fingerprints TEXT NOT NULL,"
+                 "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP)");
+
+        txn.commit();
+        std::cout << "[ANALYSIS DB] Tables created/verified" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "[ANALYSIS DB ERROR] Table creation: " << e.what() << std::endl;
+        throw;
+    }
 }
 
 Database::WorkInfo Database::get_work_info(int work_id) {
+    WorkInfo cached;
+    if (work_cache->get(work_id, cached)) {
+        return cached;
+    }
+
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT id, student_id, student_name, assignment_id, file_path, file_hash, status "
-            "FROM works WHERE id = $1",
-            work_id
-        );
-        
-        if (result.empty()) {
-            throw std::runtime_error("Work not found with ID: " + std::to_string(work_id));
-        }
-        
-        WorkInfo info;
-        info.id = result[0]["id"].as<int>();
-        info.student_id = result[0]["student_id"].as<std::string>();
-        info.student_name = result[0]["student_name"].as<std::string>();
-        info.assignment_id = result[0]["assignment_id"].as<std::string>();
-        info.file_path = result[0]["file_path"].as<std::string>();
-        info.file_hash = result[0]["file_hash"].as<std::string>();
-        info.status = result[0]["status"].as<std::string>();
-        
+        WorkInfo info = pool->run([&](pqxx::connection& conn) -> WorkInfo {
+            pqxx::read_transaction txn(conn);
+            pqxx::result result = txn.exec_prepared("get_work_info", work_id);
+            
+            if (result.empty()) {
+                throw std::runtime_error("Work not found with ID: " + std::to_string(work_id));
+            }
+            
+            return read_work_info(result[0]);
+        });
+        work_cache->put(info);
         return info;
     } catch (const std::exception& e) {
         std::cerr << "[ANALYSIS DB ERROR] get_work_info: " << e.what() << std::endl;
@@ -55,31 +123,73 @@ Database::WorkInfo Database::get_work_info(int work_id) {
     }
 }
 
+std::vector<Database::WorkInfo> Database::get_works_by_assignment(const std::string& assignment_id) {
+    try {
+        auto works = pool->run([&](pqxx::connection& conn) -> std::vector<WorkInfo> {
+            pqxx::read_transaction txn(conn);
+            pqxx::result result = txn.exec_prepared("get_works_by_assignment", assignment_id);
+
+            std::vector<WorkInfo> works;
+            works.reserve(result.size());
+            for (const auto& row : result) {
+                works.push_back(read_work_info(row));
+            }
+
+            return works;
+        });
+
+        // Clustering is usually followed by per-work lookups of the same rows.
+        for (const auto& info : works) {
+            work_cache->put(info);
+        }
+        return works;
+    } catch (const std::exception& e) {
+        std::cerr << "[ANALYSIS DB ERROR] get_works_by_assignment: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+bool Database::get_work_by_hash(const std::string& file_hash, WorkInfo& info) {
+    if (work_cache->get_by_hash(file_hash, info)) {
+        return true;
+    }
+
+    bool found = pool->run([&](pqxx::connection& conn) -> bool {
+        pqxx::read_transaction txn(conn);
+        pqxx::result result = txn.exec_prepared("get_work_by_hash", file_hash);
+
+        if (result.empty()) {
+            return false;
+        }
+
+        info = read_work_info(result[0]);
+        return true;
+    });
+
+    if (found) {
+        work_cache->put(info);
+    }
+    return found;
+}
+
 std::vector<Database::SimilarWork> Database::find_similar_works(const std::string& file_hash, 
                                                                const std::string& exclude_student_id) {
-    std::vector<SimilarWork> similar_works;
-    
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT id, student_id, student_name, file_hash FROM works "
-            "WHERE file_hash = $1 AND student_id != $2 AND status != 'duplicate_detected'",
-            file_hash, exclude_student_id
-        );
-        
-        for (const auto& row : result) {
-            SimilarWork work;
-            work.id = row["id"].as<int>();
-            work.student_id = row["student_id"].as<std::string>();
-            work.student_name = row["student_name"].as<std::string>();
-            work.file_hash = row["file_hash"].as<std::string>();
-            similar_works.push_back(work);
+        WorkInfo info;
+        if (!get_work_by_hash(file_hash, info) ||
+            info.student_id == exclude_student_id || info.status == "duplicate_detected") {
+            return {};
         }
-        
-        return similar_works;
+
+        SimilarWork work;
+        work.id = info.id;
+        work.student_id = info.student_id;
+        work.student_name = info.student_name;
+        work.file_hash = info.file_hash;
+        return {work};
     } catch (const std::exception& e) {
         std::cerr << "[ANALYSIS DB ERROR] find_similar_works: " << e.what() << std::endl;
-        return similar_works;
+        return {};
     }
 }
 
@@ -89,81 +199,145 @@ void Database::save_report(int work_id,
                           int matched_work_id,
                           const std::string& matched_student_name,
                           const std::string& report_data) {
+    save_reports({{work_id, plagiarism_found, similarity_percentage,
+                   matched_work_id, matched_student_name, report_data}});
+}
+
+void Database::save_reports(const std::vector<Report>& reports) {
+    if (reports.empty()) {
+        return;
+    }
+
+    std::unordered_map<int, const Report*> latest;
+    std::vector<int> work_ids;
+    for (const auto& report : reports) {
+        if (latest.count(report.work_id) == 0) {
+            work_ids.push_back(report.work_id);
+        }
+        latest[report.work_id] = &report;
+    }
+
     try {
-        pqxx::work txn(*conn);
-
-        txn.exec_params("DELETE FROM reports WHERE work_id = $1", work_id);
-
-        txn.exec_params(
-            "INSERT INTO reports (work_id, plagiarism_found, similarity_percentage, "
-            "matched_work_id, matched_student_name, report_data) "
-            "VALUES ($1, $2, $3, $4, $5, $6)",
-            work_id,
-            plagiarism_found,
-            similarity_percentage,
-            matched_work_id,
-            matched_student_name,
-            report_data
-        );
-
-        std::string status = plagiarism_found ? "plagiarism_found" : "checked_ok";
-        txn.exec_params(
-            "UPDATE works SET status = $1 WHERE id = $2",
-            status, work_id
-        );
-        
-        txn.commit();
-        std::cout << "[ANALYSIS DB] Report saved for work ID: " << work_id << std::endl;
+        pool->run([&](pqxx::connection& conn) {
+            pqxx::work txn(conn);
+
+            std::string id_list;
+            std::string values;
+            std::string statuses;
+            for (int work_id : work_ids) {
+                const Report& report = *latest[work_id];
+                if (!id_list.empty()) {
+                    id_list += ',';
+                    values += ',';
+                    statuses += ',';
+                }
+                id_list += std::to_string(work_id);
+
+                // Works without a match carry a negative id; the column
+                // references works(id), so it is stored as NULL.
+                std::string matched_id = report.matched_work_id > 0
+                    ? std::to_string(report.matched_work_id) : "NULL";
+                values += "(" + std::to_string(work_id) + "," + txn.quote(report.plagiarism_found) + "," +
+                          txn.quote(report.similarity_percentage) + "," + matched_id + "," +
+                          txn.quote(report.matched_student_name) + "," + txn.quote(report.report_data) + ")";
+
+                std::string status = report.plagiarism_found ? "plagiarism_found" : "checked_ok";
+                statuses += "(" + std::to_string(work_id) + "," + txn.quote(status) + ")";
+            }
+
+            txn.exec("DELETE FROM reports WHERE work_id IN (" + id_list + ")");
+            txn.exec("INSERT INTO reports (work_id, plagiarism_found, similarity_percentage, "
+                     "matched_work_id, matched_student_name, report_data) VALUES " + values);
+            txn.exec("UPDATE works SET status = v.status FROM (VALUES " + statuses + ") "
+                     "AS v(id, status) WHERE works.id = v.id");
+
+            txn.commit();
+        });
+
+        for (int work_id : work_ids) {
+            work_cache->invalidate(work_id);
+        }
+        if (work_ids.size() == 1) {
+            std::cout << "[ANALYSIS DB] Report saved for work ID: " << work_ids[0] << std::endl;
+        } else {
+            std::cout << "[ANALYSIS DB] Saved " << work_ids.size() << " reports in one transaction" << std::endl;
+        }
     } catch (const std::exception& e) {
-        std::cerr << "[ANALYSIS DB ERROR] save_report: " << e.what() << std::endl;
+        std::cerr << "[ANALYSIS DB ERROR] save_reports: " << e.what() << std::endl;
         throw;
     }
 }
 
-bool Database::report_exists(int work_id) {
+bool Database::fetch_report(int work_id, std::string& report_json) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT COUNT(*) as count FROM reports WHERE work_id = $1",
-            work_id
-        );
-        
-        return result[0]["count"].as<int>() > 0;
+        return pool->run([&](pqxx::connection& conn) -> bool {
+            pqxx::read_transaction txn(conn);
+            pqxx::result result = txn.exec_prepared("fetch_report", work_id);
+            
+            if (result.empty()) {
+                return false;
+            }
+            
+            const auto& field = result[0][0];
+            report_json.assign(field.c_str(), field.size());
+            return true;
+        });
     } catch (const std::exception& e) {
-        std::cerr << "[ANALYSIS DB ERROR] report_exists: " << e.what() << std::endl;
-        return false;
+        std::cerr << "[ANALYSIS DB ERROR] fetch_report: " << e.what() << std::endl;
+        throw;
     }
 }
 
-std::string Database::get_report(int work_id) {
+void Database::update_work_status(int work_id, const std::string& status) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT report_data::text as report FROM reports WHERE work_id = $1",
-            work_id
-        );
-        
-        if (result.empty()) {
-            return "{}";
-        }
-        
-        return result[0]["report"].as<std::string>();
+        pool->run([&](pqxx::connection& conn) {
+            pqxx::work txn(conn);
+            txn.exec_prepared("update_work_status", status, work_id);
+            txn.commit();
+        });
+        work_cache->invalidate(work_id);
     } catch (const std::exception& e) {
-        std::cerr << "[ANALYSIS DB ERROR] get_report: " << e.what() << std::endl;
-        return "{}";
+        std::cerr << "[ANALYSIS DB ERROR] update_work_status: " << e.what() << std::endl;
+        throw;
     }
 }
 
-void Database::update_work_status(int work_id, const std::string& status) {
+void Database::save_fingerprints(int work_id, const std::string& fingerprints) {
     try {
-        pqxx::work txn(*conn);
-        txn.exec_params(
-            "UPDATE works SET status = $1 WHERE id = $2",
-            status, work_id
-        );
-        txn.commit();
+        pool->run([&](pqxx::connection& conn) {
+            pqxx::work txn(conn);
+            txn.exec_prepared("save_fingerprints", work_id, fingerprints);
+            txn.commit();
+        });
     } catch (const std::exception& e) {
-        std::cerr << "[ANALYSIS DB ERROR] update_work_status: " << e.what() << std::endl;
+        std::cerr << "[ANALYSIS DB ERROR] save_fingerprints: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+std::vector<Database::StoredFingerprints> Database::load_fingerprints() {
+    try {
+        return pool->run([&](pqxx::connection& conn) -> std::vector<StoredFingerprints> {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("load_fingerprints");
+
+            std::vector<StoredFingerprints> stored;
+            stored.reserve(result.size());
+            for (const auto& row : result) {
+                StoredFingerprints item;
+                item.work_id = row["id"].as<int>();
+                item.student_id = row["student_id"].as<std::string>();
+                item.student_name = row["student_name"].as<std::string>();
+                item.assignment_id = row["assignment_id"].as<std::string>();
+                item.file_hash = row["file_hash"].as<std::string>();
+                item.fingerprints = row["fingerprints"].as<std::string>();
+                stored.push_back(std::move(item));
+            }
+
+            return stored;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "[ANALYSIS DB ERROR] load_fingerprints: " << e.what() << std::endl;
         throw;
     }
 }
\ No newline at end of file
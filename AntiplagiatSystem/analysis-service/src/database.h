@@ -1,14 +1,19 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
 #include <pqxx/pqxx>
+#include "connection_pool.h"
+
+class WorkCache;
 
 class Database {
 private:
-    std::unique_ptr<pqxx::connection> conn;
+    std::unique_ptr<ConnectionPool> pool;
+    std::unique_ptr<WorkCache> work_cache;
     
 public:
-    Database(const std::string& connection_string);
+    Database(const std::string& connection_string, size_t pool_size = 8);
     ~Database();
     
     bool is_connected() const;
@@ -19,14 +24,14 @@ public:
         std::string student_name;
         std::string assignment_id;
         std::string file_path;
+        std::string original_filename;
         std::string file_hash;
         std::string status;
     };
     
     WorkInfo get_work_info(int work_id);
-    std::string get_work_file_path(int work_id);
-    std::string get_work_file_hash(int work_id);
-    std::string get_student_id_by_hash(const std::string& file_hash);
+    std::vector<WorkInfo> get_works_by_assignment(const std::string& assignment_id);
+    size_t cached_works() const;
 
     struct SimilarWork {
         int id;
@@ -35,6 +40,8 @@ public:
         std::string file_hash;
     };
     
+    // file_hash is unique in works, so this is at most the one work holding
+    // the hash; served from the work cache when possible.
     std::vector<SimilarWork> find_similar_works(const std::string& file_hash, 
                                                 const std::string& exclude_student_id);
 
@@ -45,11 +52,40 @@ public:
                      const std::string& matched_student_name,
                      const std::string& report_data);
     
-    bool report_exists(int work_id);
-    std::string get_report(int work_id);
+    struct Report {
+        int work_id;
+        bool plagiarism_found;
+        double similarity_percentage;
+        int matched_work_id;
+        std::string matched_student_name;
+        std::string report_data;
+    };
+
+    // Replaces the reports of all given works and sets their statuses with
+    // one multi-row statement each, in a single transaction. A later entry
+    // for the same work wins.
+    void save_reports(const std::vector<Report>& reports);
+
+    // Stored report_data JSON text as-is, in a single query; false if the
+    // work has no report.
+    bool fetch_report(int work_id, std::string& report_json);
 
     void update_work_status(int work_id, const std::string& status);
+
+    struct StoredFingerprints {
+        int work_id;
+        std::string student_id;
+        std::string student_name;
+        std::string assignment_id;
+        std::string file_hash;
+        std::string fingerprints;
+    };
+
+    void save_fingerprints(int work_id, const std::string& fingerprints);
+    std::vector<StoredFingerprints> load_fingerprints();
     
 private:
-    void create_tables();
+    bool get_work_by_hash(const std::string& file_hash, WorkInfo& info);
+    void create_tables(pqxx::connection& conn);
+    static void prepare_statements(pqxx::connection& conn);
 };
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "fingerprint.h"
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+namespace {
+
+const uint64_t HASH_BASE = 1099511628211ULL;
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+inline uint64_t symbol_value(char c) {
+    return static_cast<unsigned char>(c);
+}
+
+inline uint64_t symbol_value(uint16_t token) {
+    return token;
+}
+
+template <typename Symbol>
+std::vector<uint64_t> winnow(const Symbol* symbols, size_t size, size_t k, size_t window) {
+    std::vector<uint64_t> fingerprints;
+    if (size < k) {
+        return fingerprints;
+    }
+
+    uint64_t base_pow = 1;
+    for (size_t i = 1; i < k; ++i) {
+        base_pow *= HASH_BASE;
+    }
+
+    const size_t gram_count = size - k + 1;
+    std::vector<uint64_t> grams(gram_count);
+
+    uint64_t rolling = 0;
+    for (size_t i = 0; i < k; ++i) {
+        rolling = rolling * HASH_BASE + symbol_value(symbols[i]);
+    }
+    grams[0] = mix(rolling);
+    for (size_t i = 1; i < gram_count; ++i) {
+        rolling -= base_pow * symbol_value(symbols[i - 1]);
+        rolling = rolling * HASH_BASE + symbol_value(symbols[i + k - 1]);
+        grams[i] = mix(rolling);
+    }
+
+    if (gram_count <= window) {
+        fingerprints.push_back(*std::min_element(grams.begin(), grams.end()));
+        return fingerprints;
+    }
+
+    // Monotonic deque of positions with strictly increasing hashes; on ties the
+    // rightmost minimum wins, as in the original winnowing paper.
+    std::deque<size_t> candidates;
+    size_t last_selected = gram_count;
+    fingerprints.reserve(gram_count * 2 / (window + 1) + 1);
+
+    for (size_t i = 0; i < gram_count; ++i) {
+        while (!candidates.empty() && grams[candidates.back()] >= grams[i]) {
+            candidates.pop_back();
+        }
+        candidates.push_back(i);
+
+        if (i + 1 < window) {
+            continue;
+        }
+        while (candidates.front() + window <= i) {
+            candidates.pop_front();
+        }
+        if (candidates.front() != last_selected) {
+            last_selected = candidates.front();
+            fingerprints.push_back(grams[last_selected]);
+        }
+    }
+
+    std::sort(fingerprints.begin(), fingerprints.end());
+    fingerprints.erase(std::unique(fingerprints.begin(), fingerprints.end()), fingerprints.end());
+    return fingerprints;
+}
+
+}
+
+Fingerprinter::Fingerprinter(size_t k, size_t window)
+    : k(k), window(window) {
+    if (k == 0 || window == 0) {
+        throw std::invalid_argument("Fingerprinter: k and window must be positive");
+    }
+}
+
+std::vector<uint64_t> Fingerprinter::fingerprint(const std::string& normalized_text) const {
+    return winnow(normalized_text.data(), normalized_text.size(), k, window);
+}
+
+std::vector<uint64_t> Fingerprinter::fingerprint(const std::vector<uint16_t>& tokens) const {
+    return winnow(tokens.data(), tokens.size(), k, window);
+}
+
+size_t Fingerprinter::count_shared(const std::vector<uint64_t>& a,
+                                   const std::vector<uint64_t>& b) {
+    size_t shared = 0;
+    auto it_a = a.begin();
+    auto it_b = b.begin();
+    while (it_a != a.end() && it_b != b.end()) {
+        if (*it_a < *it_b) {
+            ++it_a;
+        } else if (*it_b < *it_a) {
+            ++it_b;
+        } else {
+            ++shared;
+            ++it_a;
+            ++it_b;
+        }
+    }
+    return shared;
+}
+
+double Fingerprinter::similarity(const std::vector<uint64_t>& source,
+                                 const std::vector<uint64_t>& candidate) {
+    if (source.empty() || candidate.empty()) {
+        return 0.0;
+    }
+    return 100.0 * static_cast<double>(count_shared(source, candidate)) /
+           static_cast<double>(source.size());
+}
+
+std::string Fingerprinter::encode(const std::vector<uint64_t>& fingerprints) {
+    std::string encoded(fingerprints.size() * 16, '0');
+    size_t pos = 0;
+    for (uint64_t value : fingerprints) {
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            encoded[pos++] = HEX_DIGITS[(value >> shift) & 0xF];
+        }
+    }
+    return encoded;
+}
+
+std::vector<uint64_t> Fingerprinter::decode(const std::string& encoded) {
+    if (encoded.size() % 16 != 0) {
+        throw std::runtime_error("Invalid fingerprint encoding");
+    }
+
+    std::vector<uint64_t> fingerprints(encoded.size() / 16);
+    size_t pos = 0;
+    for (auto& value : fingerprints) {
+        value = 0;
+        for (int i = 0; i < 16; ++i) {
+            int digit = hex_value(encoded[pos++]);
+            if (digit < 0) {
+                throw std::runtime_error("Invalid fingerprint encoding");
+            }
+            value = (value << 4) | static_cast<uint64_t>(digit);
+        }
+    }
+    return fingerprints;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// k-gram hashing + winnowing: any shared run of at least k + window - 1
+// symbols (characters of normalized text, or SourceLexer tokens) is
+// guaranteed to produce a common fingerprint.
+class Fingerprinter {
+private:
+    size_t k;
+    size_t window;
+
+public:
+    Fingerprinter(size_t k = 25, size_t window = 16);
+
+    std::vector<uint64_t> fingerprint(const std::string& normalized_text) const;
+    std::vector<uint64_t> fingerprint(const std::vector<uint16_t>& tokens) const;
+
+    static double similarity(const std::vector<uint64_t>& source,
+                             const std::vector<uint64_t>& candidate);
+    static size_t count_shared(const std::vector<uint64_t>& a,
+                               const std::vector<uint64_t>& b);
+
+    static std::string encode(const std::vector<uint64_t>& fingerprints);
+    static std::vector<uint64_t> decode(const std::string& encoded);
+};
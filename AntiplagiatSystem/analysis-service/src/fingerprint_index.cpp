@@ -0,0 +1,273 @@
+#include "fingerprint_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'A', 'P', 'F', 'I'};
+const uint32_t INDEX_VERSION = 2;
+const size_t MIN_STOPWORD_POSTINGS = 50;
+
+template <typename T>
+void write_pod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_pod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+}
+
+void FingerprintIndex::append_varint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::vector<uint32_t> FingerprintIndex::decode_list(const PostingList& list) {
+    std::vector<uint32_t> ids;
+    ids.reserve(list.count);
+
+    uint32_t current = 0;
+    uint32_t value = 0;
+    int shift = 0;
+    for (char c : list.bytes) {
+        auto byte = static_cast<unsigned char>(c);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            continue;
+        }
+        current += value;
+        ids.push_back(current);
+        value = 0;
+        shift = 0;
+    }
+    return ids;
+}
+
+FingerprintIndex::PostingList FingerprintIndex::encode_list(const std::vector<uint32_t>& ids) {
+    PostingList list;
+    for (uint32_t id : ids) {
+        append_varint(list.bytes, id - list.last_id);
+        list.last_id = id;
+        list.count++;
+    }
+    return list;
+}
+
+void FingerprintIndex::add(int work_id, const std::vector<uint64_t>& fingerprints) {
+    auto id = static_cast<uint32_t>(work_id);
+
+    for (uint64_t fingerprint : fingerprints) {
+        auto& list = postings[fingerprint];
+
+        if (list.count == 0 || id > list.last_id) {
+            append_varint(list.bytes, id - list.last_id);
+            list.last_id = id;
+            list.count++;
+            continue;
+        }
+
+        auto ids = decode_list(list);
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos != ids.end() && *pos == id) {
+            continue;
+        }
+        ids.insert(pos, id);
+        list = encode_list(ids);
+    }
+
+    work_count++;
+}
+
+void FingerprintIndex::remove(int work_id, const std::vector<uint64_t>& fingerprints) {
+    auto id = static_cast<uint32_t>(work_id);
+
+    for (uint64_t fingerprint : fingerprints) {
+        auto it = postings.find(fingerprint);
+        if (it == postings.end()) {
+            continue;
+        }
+
+        auto ids = decode_list(it->second);
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos == ids.end() || *pos != id) {
+            continue;
+        }
+        ids.erase(pos);
+
+        if (ids.empty()) {
+            postings.erase(it);
+        } else {
+            it->second = encode_list(ids);
+        }
+    }
+
+    if (work_count > 0) {
+        work_count--;
+    }
+}
+
+void FingerprintIndex::clear() {
+    postings.clear();
+    work_count = 0;
+}
+
+size_t FingerprintIndex::size() const {
+    return work_count;
+}
+
+size_t FingerprintIndex::fingerprint_count() const {
+    return postings.size();
+}
+
+std::vector<FingerprintIndex::Candidate> FingerprintIndex::top_candidates(
+        const std::vector<uint64_t>& fingerprints,
+        size_t limit,
+        const std::function<bool(int)>& skip,
+        double max_document_share) const {
+    size_t max_postings = std::max(MIN_STOPWORD_POSTINGS,
+        static_cast<size_t>(max_document_share * static_cast<double>(work_count)));
+
+    std::unordered_map<uint32_t, uint32_t> shared_counts;
+    for (uint64_t fingerprint : fingerprints) {
+        auto it = postings.find(fingerprint);
+        if (it == postings.end() || it->second.count > max_postings) {
+            continue;
+        }
+        for (uint32_t id : decode_list(it->second)) {
+            shared_counts[id]++;
+        }
+    }
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(shared_counts.size());
+    for (const auto& [id, shared] : shared_counts) {
+        int work_id = static_cast<int>(id);
+        if (skip && skip(work_id)) {
+            continue;
+        }
+        candidates.push_back({work_id, shared});
+    }
+
+    auto by_shared = [](const Candidate& a, const Candidate& b) {
+        return a.shared != b.shared ? a.shared > b.shared : a.work_id < b.work_id;
+    };
+
+    if (candidates.size() > limit) {
+        std::partial_sort(candidates.begin(), candidates.begin() + limit,
+                          candidates.end(), by_shared);
+        candidates.resize(limit);
+    } else {
+        std::sort(candidates.begin(), candidates.end(), by_shared);
+    }
+
+    return candidates;
+}
+
+std::unordered_map<int, uint32_t> FingerprintIndex::works_sharing(
+        const std::vector<uint64_t>& fingerprints,
+        double max_document_share) const {
+    size_t max_postings = std::max(MIN_STOPWORD_POSTINGS,
+        static_cast<size_t>(max_document_share * static_cast<double>(work_count)));
+
+    std::unordered_map<int, uint32_t> works;
+    for (uint64_t fingerprint : fingerprints) {
+        auto it = postings.find(fingerprint);
+        if (it == postings.end() || it->second.count > max_postings) {
+            continue;
+        }
+        for (uint32_t id : decode_list(it->second)) {
+            works[static_cast<int>(id)]++;
+        }
+    }
+    return works;
+}
+
+bool FingerprintIndex::save(const std::string& path, uint64_t checksum) const {
+    std::string temp_path = path + ".tmp";
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "[INDEX ERROR] Cannot write " << temp_path << std::endl;
+            return false;
+        }
+
+        out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        write_pod(out, INDEX_VERSION);
+        write_pod(out, checksum);
+        write_pod(out, static_cast<uint64_t>(work_count));
+        write_pod(out, static_cast<uint64_t>(postings.size()));
+
+        for (const auto& [fingerprint, list] : postings) {
+            write_pod(out, fingerprint);
+            write_pod(out, list.last_id);
+            write_pod(out, list.count);
+            write_pod(out, static_cast<uint32_t>(list.bytes.size()));
+            out.write(list.bytes.data(), static_cast<std::streamsize>(list.bytes.size()));
+        }
+
+        if (!out) {
+            std::cerr << "[INDEX ERROR] Failed writing " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "[INDEX ERROR] Cannot replace " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FingerprintIndex::load(const std::string& path, uint64_t& checksum) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t stored_checksum = 0;
+    uint64_t stored_works = 0;
+    uint64_t stored_postings = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !read_pod(in, version) || version != INDEX_VERSION || !read_pod(in, stored_checksum) ||
+        !read_pod(in, stored_works) || !read_pod(in, stored_postings)) {
+        std::cerr << "[INDEX ERROR] Invalid index header in " << path << std::endl;
+        return false;
+    }
+
+    std::unordered_map<uint64_t, PostingList> loaded;
+    loaded.reserve(stored_postings);
+    for (uint64_t i = 0; i < stored_postings; ++i) {
+        uint64_t fingerprint = 0;
+        uint32_t byte_count = 0;
+        PostingList list;
+        if (!read_pod(in, fingerprint) || !read_pod(in, list.last_id) ||
+            !read_pod(in, list.count) || !read_pod(in, byte_count)) {
+            std::cerr << "[INDEX ERROR] Truncated index " << path << std::endl;
+            return false;
+        }
+        list.bytes.resize(byte_count);
+        if (!in.read(list.bytes.data(), byte_count)) {
+            std::cerr << "[INDEX ERROR] Truncated index " << path << std::endl;
+            return false;
+        }
+        loaded.emplace(fingerprint, std::move(list));
+    }
+
+    postings = std::move(loaded);
+    work_count = static_cast<size_t>(stored_works);
+    checksum = stored_checksum;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+// Inverted index fingerprint -> sorted work ids. Posting lists are stored as
+// delta + varint encoded bytes. Not thread-safe: callers hold their own lock.
+class FingerprintIndex {
+private:
+    struct PostingList {
+        std::string bytes;
+        uint32_t last_id = 0;
+        uint32_t count = 0;
+    };
+
+    std::unordered_map<uint64_t, PostingList> postings;
+    size_t work_count = 0;
+
+    static void append_varint(std::string& out, uint32_t value);
+    static std::vector<uint32_t> decode_list(const PostingList& list);
+    static PostingList encode_list(const std::vector<uint32_t>& ids);
+
+public:
+    struct Candidate {
+        int work_id;
+        uint32_t shared;
+    };
+
+    void add(int work_id, const std::vector<uint64_t>& fingerprints);
+    void remove(int work_id, const std::vector<uint64_t>& fingerprints);
+    void clear();
+
+    size_t size() const;
+    size_t fingerprint_count() const;
+
+    // Work ids ranked by the number of shared fingerprints. Fingerprints that
+    // occur in more than max_document_share of all works are skipped.
+    std::vector<Candidate> top_candidates(const std::vector<uint64_t>& fingerprints,
+                                          size_t limit,
+                                          const std::function<bool(int)>& skip,
+                                          double max_document_share = 0.1) const;
+
+    // Works posted under any of the fingerprints, with how many of them each
+    // holds; common fingerprints are skipped as in top_candidates.
+    std::unordered_map<int, uint32_t> works_sharing(const std::vector<uint64_t>& fingerprints,
+                                                    double max_document_share = 0.1) const;
+
+    // The checksum identifies the fingerprints the index was built from; the
+    // caller compares it on load to detect an index that went stale.
+    bool save(const std::string& path, uint64_t checksum) const;
+    bool load(const std::string& path, uint64_t& checksum);
+};
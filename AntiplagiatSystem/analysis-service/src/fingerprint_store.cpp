@@ -0,0 +1,386 @@
+#include "fingerprint_store.h"
+#include "fingerprint.h"
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <mutex>
+
+namespace {
+const size_t CANDIDATE_LIMIT = 20;
+const size_t SAVE_INDEX_EVERY = 256;
+const size_t RESCORE_NEWER_LIMIT = 256;
+const size_t RESCORE_GAINED_LIMIT = 256;
+
+// How many of the (sorted) changed fingerprints the sorted set holds.
+int64_t count_present(const std::vector<uint64_t>& fingerprints, const std::vector<uint64_t>& changed) {
+    int64_t present = 0;
+    for (uint64_t fingerprint : changed) {
+        if (std::binary_search(fingerprints.begin(), fingerprints.end(), fingerprint)) {
+            present++;
+        }
+    }
+    return present;
+}
+
+// Keeps the scores of the CANDIDATE_LIMIT closest works so they don't grow
+// with every rescoring.
+void keep_top(FingerprintStore::Scores& scores) {
+    if (scores.shared.size() <= CANDIDATE_LIMIT) {
+        return;
+    }
+
+    std::vector<std::pair<int, uint32_t>> ranked(scores.shared.begin(), scores.shared.end());
+    std::nth_element(ranked.begin(), ranked.begin() + CANDIDATE_LIMIT, ranked.end(),
+        [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+    ranked.resize(CANDIDATE_LIMIT);
+    scores.shared = std::unordered_map<int, uint32_t>(ranked.begin(), ranked.end());
+}
+
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64_t entry_checksum(const FingerprintStore::Entry& entry) {
+    uint64_t checksum = mix(static_cast<uint64_t>(entry.work_id));
+    for (uint64_t fingerprint : entry.fingerprints) {
+        checksum = mix(checksum ^ fingerprint);
+    }
+    return checksum;
+}
+}
+
+FingerprintStore::FingerprintStore(const std::string& index_path)
+    : index_path(index_path) {}
+
+void FingerprintStore::put(Entry entry) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        int work_id = entry.work_id;
+
+        auto existing = entries.find(work_id);
+        if (existing != entries.end()) {
+            index.remove(work_id, existing->second.fingerprints);
+            content_checksum -= entry_checksum(existing->second);
+            by_generation.erase(existing->second.generation);
+        }
+        entry.generation = ++generation;
+        by_generation[entry.generation] = work_id;
+        content_checksum += entry_checksum(entry);
+        index.add(work_id, entry.fingerprints);
+        entries[work_id] = std::move(entry);
+
+        if (++unsaved_updates < SAVE_INDEX_EVERY) {
+            return;
+        }
+    }
+
+    // A save already in progress is followed up by the next put.
+    std::unique_lock<std::mutex> save_lock(save_mutex, std::try_to_lock);
+    if (save_lock.owns_lock()) {
+        write_index();
+    }
+}
+
+void FingerprintStore::rebuild_index() {
+    index.clear();
+    for (const auto& [work_id, entry] : entries) {
+        index.add(work_id, entry.fingerprints);
+    }
+}
+
+void FingerprintStore::save_index() {
+    std::lock_guard<std::mutex> save_lock(save_mutex);
+    write_index();
+}
+
+void FingerprintStore::write_index() {
+    FingerprintIndex snapshot;
+    uint64_t checksum = 0;
+    size_t updates = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (index_path.empty() || !persist_index) {
+            return;
+        }
+        snapshot = index;
+        checksum = content_checksum;
+        updates = unsaved_updates;
+    }
+
+    if (snapshot.save(index_path, checksum)) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        unsaved_updates -= std::min(unsaved_updates, updates);
+    }
+}
+
+void FingerprintStore::load(Database& db) {
+    std::vector<Database::StoredFingerprints> stored;
+    try {
+        stored = db.load_fingerprints();
+    } catch (const std::exception& e) {
+        std::cerr << "[FINGERPRINTS ERROR] Cannot load fingerprints, keeping " << index_path
+                  << " untouched: " << e.what() << std::endl;
+        return;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (auto& row : stored) {
+            try {
+                Entry entry;
+                entry.work_id = row.work_id;
+                entry.student_id = std::move(row.student_id);
+                entry.student_name = std::move(row.student_name);
+                entry.assignment_id = std::move(row.assignment_id);
+                entry.file_hash = std::move(row.file_hash);
+                entry.fingerprints = Fingerprinter::decode(row.fingerprints);
+                entries[entry.work_id] = std::move(entry);
+            } catch (const std::exception& e) {
+                std::cerr << "[FINGERPRINTS ERROR] Skipping work " << row.work_id
+                          << ": " << e.what() << std::endl;
+            }
+        }
+
+        content_checksum = 0;
+        for (const auto& [work_id, entry] : entries) {
+            content_checksum += entry_checksum(entry);
+        }
+        persist_index = true;
+
+        std::cout << "[FINGERPRINTS] Loaded " << entries.size() << " works" << std::endl;
+
+        // A work re-analysed since the last save keeps the count but not the
+        // fingerprints, so the file is trusted only if its checksum matches.
+        uint64_t stored_checksum = 0;
+        if (!index_path.empty() && index.load(index_path, stored_checksum) &&
+            stored_checksum == content_checksum && index.size() == entries.size()) {
+            std::cout << "[FINGERPRINTS] Index loaded from " << index_path << std::endl;
+            return;
+        }
+
+        rebuild_index();
+        std::cout << "[FINGERPRINTS] Index rebuilt: " << index.fingerprint_count()
+                  << " fingerprints" << std::endl;
+    }
+
+    save_index();
+}
+
+size_t FingerprintStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return entries.size();
+}
+
+bool FingerprintStore::contains(int work_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return entries.count(work_id) > 0;
+}
+
+bool FingerprintStore::contains(int work_id, const std::string& file_hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = entries.find(work_id);
+    return it != entries.end() && it->second.file_hash == file_hash;
+}
+
+bool FingerprintStore::skip_candidate(int work_id, int exclude_work_id,
+                                      const std::string& exclude_student_id) const {
+    if (work_id == exclude_work_id) {
+        return true;
+    }
+    auto it = entries.find(work_id);
+    return it == entries.end() || it->second.student_id == exclude_student_id;
+}
+
+std::vector<FingerprintStore::Match> FingerprintStore::find_matches(const std::vector<uint64_t>& fingerprints,
+                                                                    int exclude_work_id,
+                                                                    const std::string& exclude_student_id,
+                                                                    size_t limit, Scores* scores) const {
+    Scores local;
+    Scores& target = scores ? *scores : local;
+    if (fingerprints.empty()) {
+        target = Scores();
+        return {};
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return score_candidates(fingerprints, exclude_work_id, exclude_student_id, limit, target);
+}
+
+std::vector<FingerprintStore::Match> FingerprintStore::score_candidates(const std::vector<uint64_t>& fingerprints,
+                                                                        int exclude_work_id,
+                                                                        const std::string& exclude_student_id,
+                                                                        size_t limit, Scores& scores) const {
+    auto candidates = index.top_candidates(fingerprints, CANDIDATE_LIMIT, [&](int work_id) {
+        return skip_candidate(work_id, exclude_work_id, exclude_student_id);
+    });
+
+    scores.generation = generation;
+    scores.shared.clear();
+    for (const auto& candidate : candidates) {
+        scores.shared[candidate.work_id] = static_cast<uint32_t>(
+            Fingerprinter::count_shared(fingerprints, entries.at(candidate.work_id).fingerprints));
+    }
+
+    return ranked(fingerprints, scores, limit);
+}
+
+std::vector<FingerprintStore::Match> FingerprintStore::rescore_matches(
+        const std::vector<uint64_t>& fingerprints,
+        const std::vector<uint64_t>& previous_fingerprints,
+        const Scores& previous,
+        int exclude_work_id,
+        const std::string& exclude_student_id,
+        size_t limit, Scores& scores) const {
+    if (fingerprints.empty()) {
+        scores = Scores();
+        return {};
+    }
+
+    std::vector<uint64_t> added;
+    std::vector<uint64_t> removed;
+    std::set_difference(fingerprints.begin(), fingerprints.end(),
+                        previous_fingerprints.begin(), previous_fingerprints.end(),
+                        std::back_inserter(added));
+    std::set_difference(previous_fingerprints.begin(), previous_fingerprints.end(),
+                        fingerprints.begin(), fingerprints.end(),
+                        std::back_inserter(removed));
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    if (added.size() + removed.size() > fingerprints.size() / 2) {
+        return score_candidates(fingerprints, exclude_work_id, exclude_student_id, limit, scores);
+    }
+
+    auto first_newer = by_generation.upper_bound(previous.generation);
+    if (static_cast<size_t>(std::distance(first_newer, by_generation.end())) > RESCORE_NEWER_LIMIT) {
+        return score_candidates(fingerprints, exclude_work_id, exclude_student_id, limit, scores);
+    }
+
+    // previous.shared holds only the top candidates. If one of them loses a
+    // fingerprint, a lower-ranked work it was never compared with could
+    // overtake it, so only a full ranking is exact then.
+    std::unordered_map<int, uint32_t> adjusted;
+    for (const auto& [work_id, shared] : previous.shared) {
+        auto it = entries.find(work_id);
+        if (it == entries.end() || it->second.generation > previous.generation ||
+            skip_candidate(work_id, exclude_work_id, exclude_student_id)) {
+            continue;
+        }
+        const auto& theirs = it->second.fingerprints;
+        if (count_present(theirs, removed) > 0) {
+            return score_candidates(fingerprints, exclude_work_id, exclude_student_id, limit, scores);
+        }
+        adjusted[work_id] = shared + static_cast<uint32_t>(count_present(theirs, added));
+    }
+
+    std::vector<int> gained;
+    for (const auto& [work_id, hits] : index.works_sharing(added)) {
+        if (adjusted.count(work_id) || skip_candidate(work_id, exclude_work_id, exclude_student_id) ||
+            entries.at(work_id).generation > previous.generation) {
+            continue;
+        }
+        gained.push_back(work_id);
+        if (gained.size() > RESCORE_GAINED_LIMIT) {
+            return score_candidates(fingerprints, exclude_work_id, exclude_student_id, limit, scores);
+        }
+    }
+
+    scores.generation = generation;
+    scores.shared = std::move(adjusted);
+
+    // Works that gained added fingerprints are counted exactly: their
+    // earlier count is unknown, so the added hits alone cannot rank them.
+    for (int work_id : gained) {
+        scores.shared[work_id] = static_cast<uint32_t>(
+            Fingerprinter::count_shared(fingerprints, entries.at(work_id).fingerprints));
+    }
+
+    for (auto it = first_newer; it != by_generation.end(); ++it) {
+        if (skip_candidate(it->second, exclude_work_id, exclude_student_id)) {
+            continue;
+        }
+        scores.shared[it->second] = static_cast<uint32_t>(
+            Fingerprinter::count_shared(fingerprints, entries.at(it->second).fingerprints));
+    }
+
+    keep_top(scores);
+    return ranked(fingerprints, scores, limit);
+}
+
+std::vector<FingerprintStore::Match> FingerprintStore::ranked(const std::vector<uint64_t>& fingerprints,
+                                                              const Scores& scores, size_t limit) const {
+    std::vector<Match> matches;
+    for (const auto& [work_id, shared] : scores.shared) {
+        if (shared == 0) {
+            continue;
+        }
+        const auto& entry = entries.at(work_id);
+
+        Match match;
+        match.work.id = entry.work_id;
+        match.work.student_id = entry.student_id;
+        match.work.student_name = entry.student_name;
+        match.work.file_hash = entry.file_hash;
+        match.similarity = 100.0 * static_cast<double>(shared) / static_cast<double>(fingerprints.size());
+        matches.push_back(std::move(match));
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.similarity != b.similarity ? a.similarity > b.similarity : a.work.id < b.work.id;
+    });
+    if (matches.size() > limit) {
+        matches.resize(limit);
+    }
+    return matches;
+}
+
+std::vector<FingerprintStore::SignedWork> FingerprintStore::assignment_signatures(
+        const std::string& assignment_id, const MinHasher& hasher) {
+    struct Unsigned {
+        size_t position;
+        uint64_t generation;
+        std::vector<uint64_t> fingerprints;
+    };
+
+    std::vector<SignedWork> works;
+    std::vector<Unsigned> unsigned_works;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& [work_id, entry] : entries) {
+            if (entry.assignment_id != assignment_id) {
+                continue;
+            }
+            if (entry.signature.size() != hasher.size()) {
+                unsigned_works.push_back({works.size(), entry.generation, entry.fingerprints});
+            }
+            works.push_back({work_id, entry.student_id, entry.student_name, entry.signature});
+        }
+    }
+
+    // Signatures are computed with no lock held, so clustering a large
+    // assignment does not stall concurrent analyses.
+    for (auto& work : unsigned_works) {
+        works[work.position].signature = hasher.signature(work.fingerprints);
+    }
+
+    if (!unsigned_works.empty()) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (const auto& work : unsigned_works) {
+            // A work put again meanwhile has other fingerprints; it is signed
+            // on the next clustering.
+            auto it = entries.find(works[work.position].work_id);
+            if (it != entries.end() && it->second.generation == work.generation) {
+                it->second.signature = works[work.position].signature;
+            }
+        }
+    }
+
+    return works;
+}
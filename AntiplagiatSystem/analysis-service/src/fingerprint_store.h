@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include "database.h"
+#include "fingerprint_index.h"
+#include "minhash.h"
+
+class FingerprintStore {
+public:
+    struct Entry {
+        int work_id;
+        std::string student_id;
+        std::string student_name;
+        std::string assignment_id;
+        std::string file_hash;
+        std::vector<uint64_t> fingerprints;
+        std::vector<uint32_t> signature;
+        uint64_t generation = 0;  // store generation when it was put; 0 if loaded
+    };
+
+    // Shared fingerprint counts behind one ranking, kept so the student's
+    // next version can be rescored from the difference instead of from
+    // scratch.
+    struct Scores {
+        uint64_t generation = 0;
+        std::unordered_map<int, uint32_t> shared;
+    };
+
+    struct Match {
+        Database::SimilarWork work;
+        double similarity;
+    };
+
+    struct SignedWork {
+        int work_id;
+        std::string student_id;
+        std::string student_name;
+        std::vector<uint32_t> signature;
+    };
+
+private:
+    mutable std::shared_mutex mutex;
+    std::unordered_map<int, Entry> entries;
+    // generation -> work put under it; loaded works (generation 0) are not
+    // listed. Lets rescoring find the works stored since a ranking directly.
+    std::map<uint64_t, int> by_generation;
+    FingerprintIndex index;
+    std::string index_path;
+    size_t unsaved_updates = 0;
+    uint64_t generation = 0;
+    // Order-independent sum of per-work checksums, kept in step with
+    // entries and written into the index header.
+    uint64_t content_checksum = 0;
+    // Cleared when the fingerprints could not be read from the database, so
+    // a partial index never replaces a good file.
+    bool persist_index = false;
+    // Held while the index file is written, outside the entries lock.
+    std::mutex save_mutex;
+
+    void rebuild_index();
+    void write_index();
+    bool skip_candidate(int work_id, int exclude_work_id, const std::string& exclude_student_id) const;
+    std::vector<Match> score_candidates(const std::vector<uint64_t>& fingerprints,
+                                        int exclude_work_id,
+                                        const std::string& exclude_student_id,
+                                        size_t limit, Scores& scores) const;
+    std::vector<Match> ranked(const std::vector<uint64_t>& fingerprints,
+                              const Scores& scores, size_t limit) const;
+
+public:
+    explicit FingerprintStore(const std::string& index_path);
+
+    void put(Entry entry);
+    void load(Database& db);
+    void save_index();
+    size_t size() const;
+    bool contains(int work_id) const;
+    // True if the work is stored with fingerprints of this file content.
+    bool contains(int work_id, const std::string& file_hash) const;
+
+    // Candidates from other students ranked by similarity, best first.
+    std::vector<Match> find_matches(const std::vector<uint64_t>& fingerprints,
+                                    int exclude_work_id,
+                                    const std::string& exclude_student_id,
+                                    size_t limit, Scores* scores = nullptr) const;
+
+    // Same ranking, derived from the scores of an earlier version of the
+    // work: previous candidates are adjusted by the added fingerprints they
+    // hold, and every work holding an added fingerprint or stored since is
+    // counted exactly. Without removals no unseen work can overtake a kept
+    // candidate, so the result equals find_matches up to the candidate cut
+    // both make on fingerprints common to many works. Falls back to
+    // find_matches when a removed fingerprint is held by a previous
+    // candidate, or when the edit, the works it touches or the number of
+    // new works is large.
+    std::vector<Match> rescore_matches(const std::vector<uint64_t>& fingerprints,
+                                       const std::vector<uint64_t>& previous_fingerprints,
+                                       const Scores& previous,
+                                       int exclude_work_id,
+                                       const std::string& exclude_student_id,
+                                       size_t limit, Scores& scores) const;
+
+    std::vector<SignedWork> assignment_signatures(const std::string& assignment_id,
+                                                  const MinHasher& hasher);
+};
@@ -0,0 +1,140 @@
+#include "job_queue.h"
+#include <chrono>
+#include <iostream>
+
+JobQueue::JobQueue(size_t worker_count, size_t capacity, size_t max_finished)
+    : capacity(capacity), max_finished(max_finished) {
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([this] { worker_loop(); });
+    }
+
+    std::cout << "[JOB QUEUE] Started " << worker_count << " workers, capacity "
+              << capacity << std::endl;
+}
+
+JobQueue::~JobQueue() {
+    stop();
+}
+
+void JobQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    has_work.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    std::cout << "[JOB QUEUE] Stopped" << std::endl;
+}
+
+bool JobQueue::submit(int work_id, Task task, std::string& job_id) {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || pending.size() >= capacity) {
+            return false;
+        }
+
+        job_id = std::to_string(now) + "-" + std::to_string(next_id++);
+
+        JobInfo info;
+        info.id = job_id;
+        info.work_id = work_id;
+        info.status = Status::Queued;
+        info.created_at = std::time(nullptr);
+        info.finished_at = 0;
+        jobs.emplace(job_id, std::move(info));
+
+        pending.push_back({job_id, std::move(task)});
+    }
+
+    has_work.notify_one();
+    return true;
+}
+
+bool JobQueue::get(const std::string& job_id, JobInfo& info) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(job_id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
+
+size_t JobQueue::queued() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+size_t JobQueue::worker_count() const {
+    return workers.size();
+}
+
+void JobQueue::worker_loop() {
+    while (true) {
+        PendingJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            has_work.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+
+            job = std::move(pending.front());
+            pending.pop_front();
+            jobs[job.id].status = Status::Running;
+        }
+
+        try {
+            finish(job.id, Status::Completed, job.task(), "");
+        } catch (const std::exception& e) {
+            std::cerr << "[JOB QUEUE ERROR] Job " << job.id << ": " << e.what() << std::endl;
+            finish(job.id, Status::Failed, web::json::value::null(), e.what());
+        }
+    }
+}
+
+void JobQueue::finish(const std::string& job_id, Status status,
+                      web::json::value result, const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = jobs.find(job_id);
+    if (it == jobs.end()) {
+        return;
+    }
+    it->second.status = status;
+    it->second.result = std::move(result);
+    it->second.error = error;
+    it->second.finished_at = std::time(nullptr);
+
+    finished_order.push_back(job_id);
+    while (finished_order.size() > max_finished) {
+        jobs.erase(finished_order.front());
+        finished_order.pop_front();
+    }
+}
+
+const char* JobQueue::status_name(Status status) {
+    switch (status) {
+        case Status::Queued: return "queued";
+        case Status::Running: return "running";
+        case Status::Completed: return "completed";
+        case Status::Failed: return "failed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cpprest/json.h>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Bounded FIFO of analysis jobs executed by a fixed pool of worker threads.
+// Finished jobs are kept for polling until max_finished newer ones replace them.
+class JobQueue {
+public:
+    enum class Status { Queued, Running, Completed, Failed };
+
+    struct JobInfo {
+        std::string id;
+        int work_id;
+        Status status;
+        web::json::value result;
+        std::string error;
+        std::time_t created_at;
+        std::time_t finished_at;
+    };
+
+    using Task = std::function<web::json::value()>;
+
+private:
+    struct PendingJob {
+        std::string id;
+        Task task;
+    };
+
+    size_t capacity;
+    size_t max_finished;
+
+    mutable std::mutex mutex;
+    std::condition_variable has_work;
+    std::deque<PendingJob> pending;
+    std::unordered_map<std::string, JobInfo> jobs;
+    std::deque<std::string> finished_order;
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> next_id{1};
+    bool stopping = false;
+
+    void worker_loop();
+    void finish(const std::string& job_id, Status status,
+                web::json::value result, const std::string& error);
+
+public:
+    JobQueue(size_t worker_count, size_t capacity, size_t max_finished = 10000);
+    ~JobQueue();
+
+    bool submit(int work_id, Task task, std::string& job_id);
+    bool get(const std::string& job_id, JobInfo& info) const;
+    size_t queued() const;
+    size_t worker_count() const;
+    void stop();
+
+    static const char* status_name(Status status);
+};
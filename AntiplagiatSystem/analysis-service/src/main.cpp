@@ -1,9 +1,19 @@
 #include <iostream>
+#include <csignal>
 #include <cstdlib>
 #include <thread>
 #include <chrono>
+#include <string>
 #include "analyzer.h"
 
+namespace {
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int) {
+    stop_requested = 1;
+}
+}
+
 int main() {
     std::cout << "=== Analysis Service Starting ===" << std::endl;
 
@@ -16,6 +26,18 @@ int main() {
         std::getenv("FILE_SERVICE_URL") : "http://localhost:8081";
     std::string service_port = std::getenv("SERVICE_PORT") ? 
         std::getenv("SERVICE_PORT") : "8080";
+    std::string upload_dir = std::getenv("UPLOAD_DIR") ? 
+        std::getenv("UPLOAD_DIR") : "/app/uploads";
+    std::string index_path = std::getenv("INDEX_PATH") ? 
+        std::getenv("INDEX_PATH") : "/app/data/fingerprints.idx";
+    size_t worker_count = std::getenv("ANALYSIS_WORKERS") ? 
+        std::stoul(std::getenv("ANALYSIS_WORKERS")) : std::thread::hardware_concurrency();
+    size_t queue_capacity = std::getenv("ANALYSIS_QUEUE_CAPACITY") ? 
+        std::stoul(std::getenv("ANALYSIS_QUEUE_CAPACITY")) : 1024;
+    size_t report_batch_size = std::getenv("REPORT_BATCH_SIZE") ? 
+        std::stoul(std::getenv("REPORT_BATCH_SIZE")) : 64;
+    size_t report_batch_delay_ms = std::getenv("REPORT_BATCH_DELAY_MS") ? 
+        std::stoul(std::getenv("REPORT_BATCH_DELAY_MS")) : 5;
 
     std::string conn_str = "host=" + db_host + 
                           " port=" + db_port + 
@@ -26,18 +48,28 @@ int main() {
     std::cout << "Database connection: " << db_host << ":" << db_port << "/" << db_name << std::endl;
     std::cout << "File Service URL: " << file_service_url << std::endl;
     std::cout << "Service port: " << service_port << std::endl;
+    std::cout << "Upload directory: " << upload_dir << std::endl;
+    std::cout << "Fingerprint index: " << index_path << std::endl;
+    std::cout << "Analysis workers: " << worker_count << ", queue capacity: " << queue_capacity << std::endl;
+    std::cout << "Report batching: " << report_batch_size << " reports or " << report_batch_delay_ms << " ms" << std::endl;
     
     try {
-        Analyzer analyzer("http://0.0.0.0:" + service_port, conn_str, file_service_url);
+        Analyzer analyzer("http://0.0.0.0:" + service_port, conn_str, file_service_url, index_path,
+                          upload_dir, worker_count, queue_capacity, report_batch_size, report_batch_delay_ms);
 
         analyzer.start();
         
         std::cout << "=== Analysis Service is Running ===" << std::endl;
         std::cout << "Press Ctrl+C to stop..." << std::endl;
 
-        while (true) {
+        // Leaving the scope stops the analyzer: running jobs finish and the
+        // fingerprint index is saved.
+        std::signal(SIGINT, request_stop);
+        std::signal(SIGTERM, request_stop);
+        while (!stop_requested) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
+        std::cout << "=== Analysis Service Stopping ===" << std::endl;
         
     } catch (const std::exception& e) {
         std::cerr << "!!! FATAL ERROR !!!" << std::endl;
@@ -0,0 +1,358 @@
+#include "match_aligner.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+// SA-IS (Nong, Zhang, Chan): suffix array of s, whose symbols are in
+// [0, upper], in linear time.
+std::vector<int> suffix_array(const std::vector<int>& s, int upper) {
+    const int n = static_cast<int>(s.size());
+    if (n == 0) {
+        return {};
+    }
+    if (n == 1) {
+        return {0};
+    }
+    if (n == 2) {
+        return s[0] < s[1] ? std::vector<int>{0, 1} : std::vector<int>{1, 0};
+    }
+
+    std::vector<int> sa(n);
+    std::vector<bool> is_s(n);  // S-type: suffix i is smaller than suffix i + 1
+    for (int i = n - 2; i >= 0; --i) {
+        is_s[i] = s[i] == s[i + 1] ? is_s[i + 1] : s[i] < s[i + 1];
+    }
+
+    // Bucket boundaries: sum_l[c] is where L-type suffixes starting with c
+    // begin, sum_s[c] where the S-type ones do.
+    std::vector<int> sum_l(upper + 1), sum_s(upper + 1);
+    for (int i = 0; i < n; ++i) {
+        if (!is_s[i]) {
+            sum_s[s[i]]++;
+        } else {
+            sum_l[s[i] + 1]++;
+        }
+    }
+    for (int c = 0; c <= upper; ++c) {
+        sum_s[c] += sum_l[c];
+        if (c < upper) {
+            sum_l[c + 1] += sum_s[c];
+        }
+    }
+
+    auto induce = [&](const std::vector<int>& lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        std::vector<int> bucket(sum_s);
+        for (int d : lms) {
+            if (d != n) {
+                sa[bucket[s[d]]++] = d;
+            }
+        }
+
+        bucket = sum_l;
+        sa[bucket[s[n - 1]]++] = n - 1;
+        for (int i = 0; i < n; ++i) {
+            int v = sa[i];
+            if (v >= 1 && !is_s[v - 1]) {
+                sa[bucket[s[v - 1]]++] = v - 1;
+            }
+        }
+
+        bucket = sum_l;
+        for (int i = n - 1; i >= 0; --i) {
+            int v = sa[i];
+            if (v >= 1 && is_s[v - 1]) {
+                sa[--bucket[s[v - 1] + 1]] = v - 1;
+            }
+        }
+    };
+
+    std::vector<int> lms_index(n + 1, -1);
+    std::vector<int> lms;
+    for (int i = 1; i < n; ++i) {
+        if (!is_s[i - 1] && is_s[i]) {
+            lms_index[i] = static_cast<int>(lms.size());
+            lms.push_back(i);
+        }
+    }
+    const int m = static_cast<int>(lms.size());
+
+    induce(lms);
+
+    if (m > 0) {
+        // Name the LMS substrings in sorted order and, if some names repeat,
+        // sort them by recursing on the reduced string.
+        std::vector<int> sorted_lms;
+        sorted_lms.reserve(m);
+        for (int v : sa) {
+            if (lms_index[v] != -1) {
+                sorted_lms.push_back(v);
+            }
+        }
+
+        std::vector<int> reduced(m);
+        int reduced_upper = 0;
+        reduced[lms_index[sorted_lms[0]]] = 0;
+        for (int i = 1; i < m; ++i) {
+            int l = sorted_lms[i - 1];
+            int r = sorted_lms[i];
+            int end_l = lms_index[l] + 1 < m ? lms[lms_index[l] + 1] : n;
+            int end_r = lms_index[r] + 1 < m ? lms[lms_index[r] + 1] : n;
+
+            bool same = end_l - l == end_r - r;
+            if (same) {
+                while (l < end_l && s[l] == s[r]) {
+                    ++l;
+                    ++r;
+                }
+                same = l != n && s[l] == s[r];
+            }
+            if (!same) {
+                ++reduced_upper;
+            }
+            reduced[lms_index[sorted_lms[i]]] = reduced_upper;
+        }
+
+        auto reduced_sa = suffix_array(reduced, reduced_upper);
+        for (int i = 0; i < m; ++i) {
+            sorted_lms[i] = lms[reduced_sa[i]];
+        }
+        induce(sorted_lms);
+    }
+
+    return sa;
+}
+
+// Kasai: lcp[i] is the common prefix length of suffixes sa[i] and sa[i + 1].
+std::vector<int> lcp_array(const std::vector<int>& s, const std::vector<int>& sa) {
+    const int n = static_cast<int>(s.size());
+    std::vector<int> rank(n);
+    for (int i = 0; i < n; ++i) {
+        rank[sa[i]] = i;
+    }
+
+    std::vector<int> lcp(n > 0 ? n - 1 : 0);
+    int h = 0;
+    for (int i = 0; i < n; ++i) {
+        if (h > 0) {
+            --h;
+        }
+        if (rank[i] == 0) {
+            continue;
+        }
+        int j = sa[rank[i] - 1];
+        while (i + h < n && j + h < n && s[i + h] == s[j + h]) {
+            ++h;
+        }
+        lcp[rank[i] - 1] = h;
+    }
+    return lcp;
+}
+
+// Disjoint half-open intervals already claimed by a tile.
+class Coverage {
+private:
+    std::map<uint32_t, uint32_t> intervals;
+
+public:
+    bool overlaps(uint32_t begin, uint32_t end) const {
+        auto next = intervals.lower_bound(begin);
+        if (next != intervals.end() && next->first < end) {
+            return true;
+        }
+        return next != intervals.begin() && std::prev(next)->second > begin;
+    }
+
+    void add(uint32_t begin, uint32_t end) {
+        intervals.emplace(begin, end);
+    }
+};
+
+inline bool is_space_byte(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+}
+
+void MatchAligner::Document::index_lines(std::string_view text) {
+    line_starts.assign(1, 0);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            line_starts.push_back(static_cast<uint32_t>(i + 1));
+        }
+    }
+}
+
+MatchAligner::Document MatchAligner::Document::from_tokens(std::string_view text,
+                                                           const std::vector<uint16_t>& tokens,
+                                                           const std::vector<SourceLexer::Position>& positions) {
+    if (tokens.size() != positions.size()) {
+        throw std::invalid_argument("MatchAligner: token positions were not collected");
+    }
+
+    Document document;
+    document.symbols.assign(tokens.begin(), tokens.end());
+    document.begins.reserve(positions.size());
+    document.ends.reserve(positions.size());
+    for (const auto& position : positions) {
+        document.begins.push_back(position.offset);
+        document.ends.push_back(position.offset + position.length);
+    }
+    document.index_lines(text);
+    return document;
+}
+
+MatchAligner::Document MatchAligner::Document::from_words(std::string_view text) {
+    Document document;
+
+    size_t i = 0;
+    while (i < text.size()) {
+        if (is_space_byte(static_cast<unsigned char>(text[i]))) {
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+        uint64_t hash = 14695981039346656037ULL;
+        for (; i < text.size() && !is_space_byte(static_cast<unsigned char>(text[i])); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            c = (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+
+        document.symbols.push_back(hash);
+        document.begins.push_back(static_cast<uint32_t>(start));
+        document.ends.push_back(static_cast<uint32_t>(i));
+    }
+
+    document.index_lines(text);
+    return document;
+}
+
+uint32_t MatchAligner::Document::line_of(uint32_t offset) const {
+    auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+    return static_cast<uint32_t>(it - line_starts.begin());
+}
+
+std::vector<MatchAligner::Span> MatchAligner::align(const Document& source, const Document& target,
+                                                    size_t min_length, size_t max_spans) {
+    std::vector<Span> spans;
+    const size_t source_size = source.symbols.size();
+    const size_t target_size = target.symbols.size();
+    if (min_length == 0 || source_size < min_length || target_size < min_length ||
+        source_size + target_size + 1 > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return spans;
+    }
+
+    // Source, a unique separator (0), then target, over a dense alphabet so
+    // SA-IS buckets stay proportional to the input.
+    std::vector<uint64_t> alphabet(source.symbols);
+    alphabet.insert(alphabet.end(), target.symbols.begin(), target.symbols.end());
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+
+    auto rank_of = [&](uint64_t symbol) {
+        return static_cast<int>(std::lower_bound(alphabet.begin(), alphabet.end(), symbol) - alphabet.begin()) + 1;
+    };
+
+    const int n = static_cast<int>(source_size + target_size + 1);
+    const int separator = static_cast<int>(source_size);
+    std::vector<int> text(n);
+    for (size_t i = 0; i < source_size; ++i) {
+        text[i] = rank_of(source.symbols[i]);
+    }
+    text[separator] = 0;
+    for (size_t i = 0; i < target_size; ++i) {
+        text[separator + 1 + i] = rank_of(target.symbols[i]);
+    }
+
+    auto sa = suffix_array(text, static_cast<int>(alphabet.size()));
+    auto lcp = lcp_array(text, sa);
+
+    // For every source position, the longest match in the target is with the
+    // nearest target suffix above or below it in the suffix array.
+    std::vector<int> best_length(source_size, 0);
+    std::vector<int> best_target(source_size, -1);
+    auto sweep = [&](int from, int to, int step) {
+        int last_target = -1;
+        int run = 0;
+        for (int i = from; i != to; i += step) {
+            if (i != from) {
+                run = std::min(run, lcp[step > 0 ? i - 1 : i]);
+            }
+            int position = sa[i];
+            if (position > separator) {
+                last_target = position - separator - 1;
+                run = std::numeric_limits<int>::max();
+            } else if (position < separator && last_target >= 0 && run > best_length[position]) {
+                best_length[position] = run;
+                best_target[position] = last_target;
+            }
+        }
+    };
+    sweep(0, n, 1);
+    sweep(n - 1, -1, -1);
+
+    struct Candidate {
+        uint32_t source;
+        uint32_t target;
+        uint32_t length;
+    };
+
+    // A match that just continues the previous position's one is contained
+    // in it, so only left-maximal matches become tile candidates.
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < source_size; ++i) {
+        int length = best_length[i];
+        if (length < static_cast<int>(min_length)) {
+            continue;
+        }
+        if (i > 0 && best_length[i - 1] == length + 1 && best_target[i - 1] + 1 == best_target[i]) {
+            continue;
+        }
+        candidates.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(best_target[i]),
+                              static_cast<uint32_t>(length)});
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.length != b.length ? a.length > b.length : a.source < b.source;
+    });
+
+    Coverage source_tiles;
+    Coverage target_tiles;
+    for (const auto& candidate : candidates) {
+        if (spans.size() >= max_spans) {
+            break;
+        }
+
+        uint32_t source_end = candidate.source + candidate.length;
+        uint32_t target_end = candidate.target + candidate.length;
+        if (source_tiles.overlaps(candidate.source, source_end) ||
+            target_tiles.overlaps(candidate.target, target_end)) {
+            continue;
+        }
+        source_tiles.add(candidate.source, source_end);
+        target_tiles.add(candidate.target, target_end);
+
+        Span span;
+        span.length = candidate.length;
+        span.source.begin = source.begins[candidate.source];
+        span.source.end = source.ends[source_end - 1];
+        span.source.first_line = source.line_of(span.source.begin);
+        span.source.last_line = source.line_of(span.source.end - 1);
+        span.target.begin = target.begins[candidate.target];
+        span.target.end = target.ends[target_end - 1];
+        span.target.first_line = target.line_of(span.target.begin);
+        span.target.last_line = target.line_of(span.target.end - 1);
+        spans.push_back(span);
+    }
+
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+        return a.source.begin < b.source.begin;
+    });
+    return spans;
+}
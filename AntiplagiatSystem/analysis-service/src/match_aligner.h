@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "source_lexer.h"
+
+// Locates the regions two works have in common. Both symbol sequences go
+// into one generalized suffix array (SA-IS) with its LCP array, which gives
+// every source position its longest match in the target in linear time;
+// those matches are then laid as non-overlapping tiles, longest first, as
+// in Greedy String Tiling. Sorting the candidates makes it O(n log n).
+class MatchAligner {
+public:
+    // A work as comparable symbols (lexer tokens or lowercased words) plus
+    // the byte range each symbol came from, for mapping spans back to lines.
+    class Document {
+    private:
+        std::vector<uint64_t> symbols;
+        std::vector<uint32_t> begins;
+        std::vector<uint32_t> ends;
+        std::vector<uint32_t> line_starts;
+
+        void index_lines(std::string_view text);
+
+        friend class MatchAligner;
+
+    public:
+        static Document from_tokens(std::string_view text,
+                                    const std::vector<uint16_t>& tokens,
+                                    const std::vector<SourceLexer::Position>& positions);
+        // Whitespace-separated words, ASCII-lowercased, matching what
+        // TextNormalizer makes comparable.
+        static Document from_words(std::string_view text);
+
+        size_t size() const { return symbols.size(); }
+        uint32_t line_of(uint32_t offset) const;
+    };
+
+    struct Region {
+        uint32_t begin;       // byte offsets, end exclusive
+        uint32_t end;
+        uint32_t first_line;  // 1-based, inclusive
+        uint32_t last_line;
+    };
+
+    struct Span {
+        Region source;
+        Region target;
+        uint32_t length;  // in symbols
+    };
+
+    // Spans of at least min_length symbols, at most max_spans of the longest
+    // ones, ordered by position in the source.
+    static std::vector<Span> align(const Document& source, const Document& target,
+                                   size_t min_length, size_t max_spans);
+};
@@ -0,0 +1,194 @@
+#include "minhash.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Distinct pairs scored per clustering; bounds both the time and the set of
+// compared pairs when a template fills one bucket with most of the works.
+const size_t MAX_COMPARISONS = 1000000;
+
+uint64_t combine(uint64_t seed, uint64_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+struct DisjointSet {
+    std::vector<size_t> parent;
+
+    explicit DisjointSet(size_t size) : parent(size) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    size_t find(size_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    void unite(size_t a, size_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+};
+
+}
+
+MinHasher::MinHasher(size_t num_hashes, uint64_t seed)
+    : multipliers(num_hashes), offsets(num_hashes) {
+    std::mt19937_64 rng(seed);
+    for (size_t i = 0; i < num_hashes; ++i) {
+        multipliers[i] = rng() | 1;
+        offsets[i] = rng();
+    }
+}
+
+size_t MinHasher::size() const {
+    return multipliers.size();
+}
+
+std::vector<uint32_t> MinHasher::signature(const std::vector<uint64_t>& fingerprints) const {
+    std::vector<uint32_t> result;
+    if (fingerprints.empty()) {
+        return result;
+    }
+
+    result.assign(multipliers.size(), std::numeric_limits<uint32_t>::max());
+    for (uint64_t fingerprint : fingerprints) {
+        for (size_t i = 0; i < multipliers.size(); ++i) {
+            auto value = static_cast<uint32_t>((multipliers[i] * fingerprint + offsets[i]) >> 32);
+            result[i] = std::min(result[i], value);
+        }
+    }
+    return result;
+}
+
+double MinHasher::estimate_jaccard(const std::vector<uint32_t>& a,
+                                   const std::vector<uint32_t>& b) {
+    if (a.empty() || a.size() != b.size()) {
+        return 0.0;
+    }
+
+    size_t equal = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        equal += a[i] == b[i];
+    }
+    return static_cast<double>(equal) / static_cast<double>(a.size());
+}
+
+LshClusterer::LshClusterer(size_t bands, size_t rows)
+    : bands(bands), rows(rows) {
+    if (bands == 0 || rows == 0) {
+        throw std::invalid_argument("LshClusterer: bands and rows must be positive");
+    }
+}
+
+size_t LshClusterer::band_count() const {
+    return bands;
+}
+
+std::vector<LshClusterer::Cluster> LshClusterer::cluster(const std::vector<Item>& items,
+                                                         double threshold, bool* truncated) const {
+    std::vector<size_t> usable;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].signature && items[i].signature->size() >= bands * rows) {
+            usable.push_back(i);
+        }
+    }
+
+    std::unordered_set<uint64_t> compared;
+    std::vector<Pair> pairs;
+    DisjointSet groups(items.size());
+    bool budget_spent = false;
+
+    auto compare = [&](size_t a, size_t b) {
+        if (items[a].student_id == items[b].student_id) {
+            return;
+        }
+        uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+        if (compared.count(key)) {
+            return;
+        }
+        if (compared.size() >= MAX_COMPARISONS) {
+            budget_spent = true;
+            return;
+        }
+        compared.insert(key);
+        double jaccard = MinHasher::estimate_jaccard(*items[a].signature, *items[b].signature);
+        if (jaccard >= threshold) {
+            pairs.push_back({items[a].work_id, items[b].work_id, jaccard});
+            groups.unite(a, b);
+        }
+    };
+
+    std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+    for (size_t band = 0; band < bands && !budget_spent; ++band) {
+        buckets.clear();
+        for (size_t index : usable) {
+            const auto& signature = *items[index].signature;
+            uint64_t key = band;
+            for (size_t row = 0; row < rows; ++row) {
+                key = combine(key, signature[band * rows + row]);
+            }
+            buckets[key].push_back(index);
+        }
+
+        // Every pair in a bucket is scored, even in the huge buckets a shared
+        // template produces: copies of it can still be closer to each other
+        // than to any one member. Past the budget the result is reported as
+        // truncated instead.
+        for (const auto& [key, members] : buckets) {
+            for (size_t i = 0; i < members.size() && !budget_spent; ++i) {
+                for (size_t j = i + 1; j < members.size() && !budget_spent; ++j) {
+                    compare(members[i], members[j]);
+                }
+            }
+        }
+    }
+
+    if (truncated) {
+        *truncated = budget_spent;
+    }
+
+    std::unordered_map<int, size_t> work_index;
+    for (size_t i = 0; i < items.size(); ++i) {
+        work_index[items[i].work_id] = i;
+    }
+
+    std::unordered_map<size_t, Cluster> by_root;
+    for (const auto& pair : pairs) {
+        by_root[groups.find(work_index[pair.work_a])].pairs.push_back(pair);
+    }
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(by_root.size());
+    for (auto& [root, cluster] : by_root) {
+        for (const auto& pair : cluster.pairs) {
+            cluster.work_ids.push_back(pair.work_a);
+            cluster.work_ids.push_back(pair.work_b);
+        }
+        std::sort(cluster.work_ids.begin(), cluster.work_ids.end());
+        cluster.work_ids.erase(std::unique(cluster.work_ids.begin(), cluster.work_ids.end()),
+                               cluster.work_ids.end());
+        std::sort(cluster.pairs.begin(), cluster.pairs.end(),
+                  [](const Pair& a, const Pair& b) { return a.jaccard > b.jaccard; });
+        clusters.push_back(std::move(cluster));
+    }
+
+    std::sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.work_ids.size() != b.work_ids.size() ?
+            a.work_ids.size() > b.work_ids.size() : a.work_ids.front() < b.work_ids.front();
+    });
+
+    return clusters;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MinHasher {
+private:
+    std::vector<uint64_t> multipliers;
+    std::vector<uint64_t> offsets;
+
+public:
+    explicit MinHasher(size_t num_hashes = 128, uint64_t seed = 0x5eed0fa11ceULL);
+
+    size_t size() const;
+    std::vector<uint32_t> signature(const std::vector<uint64_t>& fingerprints) const;
+
+    static double estimate_jaccard(const std::vector<uint32_t>& a,
+                                   const std::vector<uint32_t>& b);
+};
+
+// LSH banding over MinHash signatures: works that agree on every row of at
+// least one band become candidate pairs, which are then confirmed by the
+// estimated Jaccard score and merged into clusters.
+class LshClusterer {
+public:
+    struct Item {
+        int work_id;
+        std::string student_id;
+        const std::vector<uint32_t>* signature;
+    };
+
+    struct Pair {
+        int work_a;
+        int work_b;
+        double jaccard;
+    };
+
+    struct Cluster {
+        std::vector<int> work_ids;
+        std::vector<Pair> pairs;
+    };
+
+private:
+    size_t bands;
+    size_t rows;
+
+public:
+    LshClusterer(size_t bands = 32, size_t rows = 4);
+
+    size_t band_count() const;
+    // All candidate pairs are scored up to a fixed budget of distinct pairs;
+    // *truncated is set when it ran out and some pairs were not compared.
+    std::vector<Cluster> cluster(const std::vector<Item>& items, double threshold,
+                                 bool* truncated = nullptr) const;
+};
@@ -0,0 +1,111 @@
+#include "report_writer.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+ReportWriter::ReportWriter(Database& db, size_t max_batch, std::chrono::milliseconds max_delay)
+    : db(db), max_batch(std::max<size_t>(1, max_batch)), max_delay(max_delay) {
+    writer = std::thread([this] { writer_loop(); });
+
+    std::cout << "[REPORT WRITER] Started, batch up to " << this->max_batch << " reports or "
+              << max_delay.count() << " ms" << std::endl;
+}
+
+ReportWriter::~ReportWriter() {
+    stop();
+}
+
+void ReportWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    has_reports.notify_all();
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+    std::cout << "[REPORT WRITER] Stopped" << std::endl;
+}
+
+std::future<void> ReportWriter::submit(Database::Report report) {
+    std::future<void> saved;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            throw std::runtime_error("Report writer is stopped");
+        }
+
+        queue.push_back({std::move(report), std::promise<void>(), Clock::now()});
+        saved = queue.back().saved.get_future();
+    }
+
+    has_reports.notify_one();
+    return saved;
+}
+
+size_t ReportWriter::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+void ReportWriter::writer_loop() {
+    while (true) {
+        std::vector<PendingReport> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            has_reports.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+
+            has_reports.wait_until(lock, queue.front().queued_at + max_delay, [this] {
+                return stopping || queue.size() >= max_batch;
+            });
+
+            size_t count = std::min(queue.size(), max_batch);
+            batch.reserve(count);
+            std::move(queue.begin(), queue.begin() + count, std::back_inserter(batch));
+            queue.erase(queue.begin(), queue.begin() + count);
+        }
+
+        flush(batch);
+    }
+}
+
+void ReportWriter::flush(std::vector<PendingReport>& batch) {
+    std::vector<Database::Report> reports;
+    reports.reserve(batch.size());
+    for (auto& pending : batch) {
+        reports.push_back(std::move(pending.report));
+    }
+
+    try {
+        db.save_reports(reports);
+        for (auto& pending : batch) {
+            pending.saved.set_value();
+        }
+        return;
+    } catch (const std::exception& e) {
+        if (batch.size() == 1) {
+            batch[0].saved.set_exception(std::current_exception());
+            return;
+        }
+        std::cerr << "[REPORT WRITER] Batch of " << batch.size()
+                  << " failed, saving reports one by one: " << e.what() << std::endl;
+    }
+
+    // One bad report must not fail the others that shared its transaction.
+    for (size_t i = 0; i < batch.size(); ++i) {
+        try {
+            db.save_reports({reports[i]});
+            batch[i].saved.set_value();
+        } catch (const std::exception&) {
+            batch[i].saved.set_exception(std::current_exception());
+        }
+    }
+}
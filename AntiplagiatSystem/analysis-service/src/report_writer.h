@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "database.h"
+
+// Group commit for analysis reports. Reports submitted by the workers are
+// collected until max_batch of them are waiting or the oldest one has waited
+// max_delay, then written by a single thread in one transaction, so a burst
+// of analyses costs one commit instead of one per report. The returned
+// future becomes ready once the report is committed, or holds the error.
+class ReportWriter {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingReport {
+        Database::Report report;
+        std::promise<void> saved;
+        Clock::time_point queued_at;
+    };
+
+    Database& db;
+    size_t max_batch;
+    std::chrono::milliseconds max_delay;
+
+    mutable std::mutex mutex;
+    std::condition_variable has_reports;
+    std::deque<PendingReport> queue;
+    bool stopping = false;
+    std::thread writer;
+
+    void writer_loop();
+    void flush(std::vector<PendingReport>& batch);
+
+public:
+    ReportWriter(Database& db, size_t max_batch, std::chrono::milliseconds max_delay);
+    ~ReportWriter();
+
+    std::future<void> submit(Database::Report report);
+    size_t pending() const;
+
+    // Writes out everything already submitted, then stops the thread.
+    void stop();
+};
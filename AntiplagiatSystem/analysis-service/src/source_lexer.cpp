@@ -0,0 +1,422 @@
+#include "source_lexer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+enum CharClass : uint8_t {
+    SKIP,
+    IDENT,
+    DIGIT,
+    QUOTE,
+    PUNCT
+};
+
+struct CharClasses {
+    uint8_t table[256];
+
+    CharClasses() {
+        for (int c = 0; c < 256; ++c) {
+            uint8_t cls = SKIP;
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c >= 0x80) {
+                cls = IDENT;
+            } else if (c >= '0' && c <= '9') {
+                cls = DIGIT;
+            } else if (c == '"' || c == '\'') {
+                cls = QUOTE;
+            } else if (c > ' ' && c < 0x7F) {
+                cls = PUNCT;
+            }
+            table[c] = cls;
+        }
+    }
+};
+
+const uint8_t* char_classes() {
+    static const CharClasses classes;
+    return classes.table;
+}
+
+// Longest operators first within each leading character, so matching is
+// maximal munch. Ids are 128 + position in this list.
+const char* const OPERATORS[] = {
+    ">>>=", "<<=", ">>=", ">>>", "->*", "<=>", "**=", "//=", "...",
+    "==", "!=", "<=", ">=", "&&", "||", "++", "--", "+=", "-=", "*=", "/=", "%=",
+    "&=", "|=", "^=", "<<", ">>", "->", "::", "**", "//", ":=", ".*", "##"
+};
+
+struct OperatorTable {
+    std::vector<std::pair<std::string, uint16_t>> by_first[128];
+
+    OperatorTable() {
+        const size_t count = sizeof(OPERATORS) / sizeof(OPERATORS[0]);
+        for (size_t i = 0; i < count; ++i) {
+            std::string op = OPERATORS[i];
+            by_first[static_cast<unsigned char>(op[0])].emplace_back(op, static_cast<uint16_t>(128 + i));
+        }
+        for (auto& candidates : by_first) {
+            std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+                return a.first.size() > b.first.size();
+            });
+        }
+    }
+
+    size_t match(const unsigned char* p, const unsigned char* end, uint16_t& token) const {
+        const size_t available = static_cast<size_t>(end - p);
+        for (const auto& op : by_first[*p]) {
+            if (op.first.size() <= available && std::memcmp(p, op.first.data(), op.first.size()) == 0) {
+                token = op.second;
+                return op.first.size();
+            }
+        }
+        token = *p;
+        return 1;
+    }
+};
+
+// Open-addressing table of one language's keywords; anything else lexed as
+// a word is an identifier.
+class KeywordTable {
+private:
+    struct Slot {
+        const char* word = nullptr;
+        size_t length = 0;
+        uint16_t token = 0;
+    };
+
+    static const size_t SLOT_COUNT = 256;
+    Slot slots[SLOT_COUNT];
+    size_t max_length = 0;
+
+    static size_t hash(const unsigned char* word, size_t length) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            h = (h ^ word[i]) * 16777619u;
+        }
+        return h & (SLOT_COUNT - 1);
+    }
+
+public:
+    explicit KeywordTable(std::initializer_list<const char*> words) {
+        if (words.size() * 2 > SLOT_COUNT) {
+            throw std::logic_error("KeywordTable: too many keywords");
+        }
+
+        uint16_t token = 256;
+        for (const char* word : words) {
+            size_t length = std::strlen(word);
+            size_t i = hash(reinterpret_cast<const unsigned char*>(word), length);
+            while (slots[i].length != 0) {
+                i = (i + 1) & (SLOT_COUNT - 1);
+            }
+            slots[i] = {word, length, token++};
+            max_length = std::max(max_length, length);
+        }
+    }
+
+    uint16_t find(const unsigned char* word, size_t length) const {
+        if (length > max_length) {
+            return SourceLexer::IDENTIFIER;
+        }
+        for (size_t i = hash(word, length); slots[i].length != 0; i = (i + 1) & (SLOT_COUNT - 1)) {
+            if (slots[i].length == length && std::memcmp(slots[i].word, word, length) == 0) {
+                return slots[i].token;
+            }
+        }
+        return SourceLexer::IDENTIFIER;
+    }
+};
+
+struct Syntax {
+    KeywordTable keywords;
+    bool hash_comments;     // '#' to end of line (Python)
+    bool slash_comments;    // '//' and '/* */' (C++, Java)
+    bool triple_quotes;     // """...""" strings (Python, Java text blocks)
+    bool cpp_literals;      // R"(...)" raw strings, u8/L prefixes, 1'000 separators
+    bool python_prefixes;   // r"", b"", f"", rb"" ...
+};
+
+const Syntax& syntax_for(SourceLexer::Language language) {
+    static const Syntax cpp{KeywordTable{
+        "alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch", "char",
+        "char16_t", "char32_t", "class", "const", "constexpr", "const_cast", "continue",
+        "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+        "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+        "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "nullptr",
+        "operator", "private", "protected", "public", "register", "reinterpret_cast",
+        "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast",
+        "struct", "switch", "template", "this", "thread_local", "throw", "true", "try",
+        "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+        "volatile", "wchar_t", "while", "override", "final", "include", "define", "ifdef",
+        "ifndef", "endif", "pragma"
+    }, false, true, false, true, false};
+
+    static const Syntax python{KeywordTable{
+        "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class",
+        "continue", "def", "del", "elif", "else", "except", "finally", "for", "from",
+        "global", "if", "import", "in", "is", "lambda", "nonlocal", "not", "or", "pass",
+        "raise", "return", "try", "while", "with", "yield"
+    }, true, false, true, false, true};
+
+    static const Syntax java{KeywordTable{
+        "abstract", "assert", "boolean", "break", "byte", "case", "catch", "char", "class",
+        "const", "continue", "default", "do", "double", "else", "enum", "extends", "final",
+        "finally", "float", "for", "goto", "if", "implements", "import", "instanceof", "int",
+        "interface", "long", "native", "new", "package", "private", "protected", "public",
+        "return", "short", "static", "strictfp", "super", "switch", "synchronized", "this",
+        "throw", "throws", "transient", "try", "void", "volatile", "while", "true", "false",
+        "null", "var", "record", "yield"
+    }, false, true, true, false, false};
+
+    switch (language) {
+        case SourceLexer::Language::Cpp: return cpp;
+        case SourceLexer::Language::Python: return python;
+        case SourceLexer::Language::Java: return java;
+        default: throw std::invalid_argument("SourceLexer: plain text has no token syntax");
+    }
+}
+
+const unsigned char* skip_line(const unsigned char* p, const unsigned char* end) {
+    auto newline = static_cast<const unsigned char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    return newline ? newline + 1 : end;
+}
+
+// p points just past "/*".
+const unsigned char* skip_block_comment(const unsigned char* p, const unsigned char* end) {
+    while (p < end) {
+        auto star = static_cast<const unsigned char*>(std::memchr(p, '*', static_cast<size_t>(end - p)));
+        if (!star) {
+            return end;
+        }
+        if (star + 1 < end && star[1] == '/') {
+            return star + 2;
+        }
+        p = star + 1;
+    }
+    return end;
+}
+
+// p points just past the opening quote. An unterminated literal ends at the
+// line break, which keeps one stray quote from swallowing the whole file.
+const unsigned char* skip_quoted(const unsigned char* p, const unsigned char* end, unsigned char quote) {
+    while (p < end) {
+        unsigned char c = *p++;
+        if (c == '\\') {
+            if (p < end) {
+                ++p;
+            }
+        } else if (c == quote || c == '\n') {
+            return p;
+        }
+    }
+    return end;
+}
+
+// p points just past the opening triple quote.
+const unsigned char* skip_triple_quoted(const unsigned char* p, const unsigned char* end, unsigned char quote) {
+    while (p < end) {
+        unsigned char c = *p++;
+        if (c == '\\') {
+            if (p < end) {
+                ++p;
+            }
+        } else if (c == quote && end - p >= 2 && p[0] == quote && p[1] == quote) {
+            return p + 2;
+        }
+    }
+    return end;
+}
+
+// p points at the '"' of R"delim( ... )delim".
+const unsigned char* skip_raw_string(const unsigned char* p, const unsigned char* end) {
+    const unsigned char* delim = p + 1;
+    const unsigned char* paren = delim;
+    while (paren < end && *paren != '(' && paren - delim < 16) {
+        ++paren;
+    }
+    if (paren >= end || *paren != '(') {
+        return skip_quoted(p + 1, end, '"');
+    }
+
+    std::string closing = ")";
+    closing.append(reinterpret_cast<const char*>(delim), static_cast<size_t>(paren - delim));
+    closing += '"';
+
+    std::string_view body(reinterpret_cast<const char*>(paren + 1), static_cast<size_t>(end - paren - 1));
+    size_t found = body.find(closing);
+    return found == std::string_view::npos ? end : paren + 1 + found + closing.size();
+}
+
+const unsigned char* skip_string(const unsigned char* p, const unsigned char* end, const Syntax& syntax) {
+    unsigned char quote = *p;
+    if (syntax.triple_quotes && end - p >= 3 && p[1] == quote && p[2] == quote) {
+        return skip_triple_quoted(p + 3, end, quote);
+    }
+    return skip_quoted(p + 1, end, quote);
+}
+
+// p points past the first digit (or the '.' of ".5").
+const unsigned char* skip_number(const unsigned char* p, const unsigned char* end,
+                                 const uint8_t* classes, bool digit_separators) {
+    while (p < end) {
+        unsigned char c = *p;
+        if (classes[c] == IDENT || classes[c] == DIGIT || c == '.') {
+            ++p;
+        } else if ((c == '+' || c == '-') && ((p[-1] | 0x20) == 'e' || (p[-1] | 0x20) == 'p')) {
+            ++p;
+        } else if (c == '\'' && digit_separators && p + 1 < end &&
+                   (classes[p[1]] == DIGIT || classes[p[1]] == IDENT)) {
+            p += 2;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+bool is_string_prefix(const unsigned char* word, size_t length, const Syntax& syntax, bool& raw) {
+    raw = false;
+    if (syntax.cpp_literals) {
+        std::string_view prefix(reinterpret_cast<const char*>(word), length);
+        if (prefix == "L" || prefix == "u" || prefix == "U" || prefix == "u8") {
+            return true;
+        }
+        if (prefix == "R" || prefix == "LR" || prefix == "uR" || prefix == "UR" || prefix == "u8R") {
+            raw = true;
+            return true;
+        }
+        return false;
+    }
+    if (syntax.python_prefixes && length <= 2) {
+        for (size_t i = 0; i < length; ++i) {
+            if (!std::strchr("rRbBuUfF", word[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+}
+
+const std::vector<uint16_t>& SourceLexer::tokenize(const char* data, size_t size, Language language,
+                                                   bool collect_positions) {
+    const Syntax& syntax = syntax_for(language);
+    const uint8_t* classes = char_classes();
+    static const OperatorTable operators;
+
+    tokens.clear();
+    tokens.reserve(size / 4 + 16);
+    positions.clear();
+
+    const auto* begin = reinterpret_cast<const unsigned char*>(data);
+    const auto* end = begin + size;
+    const auto* p = begin;
+
+    // Every iteration consumes at most one token.
+    while (p < end) {
+        const unsigned char* start = p;
+        unsigned char c = *p;
+        switch (classes[c]) {
+            case SKIP:
+                ++p;
+                break;
+
+            case IDENT: {
+                do {
+                    ++p;
+                } while (p < end && (classes[*p] == IDENT || classes[*p] == DIGIT));
+
+                bool raw = false;
+                if (p < end && classes[*p] == QUOTE && is_string_prefix(start, static_cast<size_t>(p - start), syntax, raw)) {
+                    p = raw && *p == '"' ? skip_raw_string(p, end) : skip_string(p, end, syntax);
+                    tokens.push_back(STRING);
+                } else {
+                    tokens.push_back(syntax.keywords.find(start, static_cast<size_t>(p - start)));
+                }
+                break;
+            }
+
+            case DIGIT:
+                p = skip_number(p + 1, end, classes, syntax.cpp_literals);
+                tokens.push_back(NUMBER);
+                break;
+
+            case QUOTE:
+                p = skip_string(p, end, syntax);
+                tokens.push_back(STRING);
+                break;
+
+            default: {
+                const bool has_next = p + 1 < end;
+                if (syntax.hash_comments && c == '#') {
+                    p = skip_line(p, end);
+                } else if (syntax.slash_comments && c == '/' && has_next && p[1] == '/') {
+                    p = skip_line(p + 2, end);
+                } else if (syntax.slash_comments && c == '/' && has_next && p[1] == '*') {
+                    p = skip_block_comment(p + 2, end);
+                } else if (c == '.' && has_next && classes[p[1]] == DIGIT) {
+                    p = skip_number(p + 1, end, classes, syntax.cpp_literals);
+                    tokens.push_back(NUMBER);
+                } else {
+                    uint16_t token;
+                    p += operators.match(p, end, token);
+                    tokens.push_back(token);
+                }
+                break;
+            }
+        }
+
+        if (collect_positions && positions.size() != tokens.size()) {
+            positions.push_back({static_cast<uint32_t>(start - begin), static_cast<uint32_t>(p - start)});
+        }
+    }
+
+    return tokens;
+}
+
+const std::vector<uint16_t>& SourceLexer::tokenize(const std::string& text, Language language,
+                                                   bool collect_positions) {
+    return tokenize(text.data(), text.size(), language, collect_positions);
+}
+
+const std::vector<SourceLexer::Position>& SourceLexer::last_positions() const {
+    return positions;
+}
+
+SourceLexer::Language SourceLexer::detect_language(const std::string& filename) {
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos || filename.find_first_of("/\\", dot) != std::string::npos) {
+        return Language::Text;
+    }
+
+    std::string extension = filename.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(c >= 'A' && c <= 'Z' ? c | 0x20 : c); });
+
+    static const char* const cpp_extensions[] = {"c", "cc", "cpp", "cxx", "c++", "h", "hh", "hpp", "hxx", "ino"};
+    for (const char* candidate : cpp_extensions) {
+        if (extension == candidate) {
+            return Language::Cpp;
+        }
+    }
+    if (extension == "py" || extension == "pyw") {
+        return Language::Python;
+    }
+    if (extension == "java") {
+        return Language::Java;
+    }
+    return Language::Text;
+}
+
+const char* SourceLexer::language_name(Language language) {
+    switch (language) {
+        case Language::Cpp: return "cpp";
+        case Language::Python: return "python";
+        case Language::Java: return "java";
+        default: return "text";
+    }
+}
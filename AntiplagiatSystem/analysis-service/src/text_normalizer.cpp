@@ -0,0 +1,209 @@
+#include "text_normalizer.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_NORMALIZER_X86 1
+#endif
+
+namespace {
+
+struct KernelState {
+    char* out_begin;
+    char* out;
+    bool prev_space;
+    bool in_token;
+    uint32_t token_start;
+    std::vector<TextNormalizer::Token>* tokens;
+};
+
+inline bool is_space_byte(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline unsigned char to_lower_byte(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+inline uint64_t block_mask(unsigned width) {
+    return width == 64 ? ~0ULL : ((1ULL << width) - 1);
+}
+
+// The block's lowercased bytes are already stored at state.out. Drops every
+// whitespace byte that follows another one (compacting in place), records
+// token boundaries and advances state.out.
+inline void finish_block(unsigned width, uint64_t space_mask, KernelState& state) {
+    const uint64_t full = block_mask(width);
+    const uint64_t prev_mask = ((space_mask << 1) | (state.prev_space ? 1ULL : 0ULL)) & full;
+    const uint64_t drop = space_mask & prev_mask;
+    const auto base = static_cast<uint32_t>(state.out - state.out_begin);
+
+    if (state.tokens) {
+        uint64_t events = (~space_mask & prev_mask) | (space_mask & ~prev_mask & full);
+        while (events) {
+            unsigned i = static_cast<unsigned>(__builtin_ctzll(events));
+            events &= events - 1;
+            uint32_t pos = base + i - static_cast<uint32_t>(
+                __builtin_popcountll(drop & ((1ULL << i) - 1)));
+            if (!((space_mask >> i) & 1)) {
+                state.token_start = pos;
+                state.in_token = true;
+            } else if (state.in_token) {
+                state.tokens->push_back({state.token_start, pos - state.token_start});
+                state.in_token = false;
+            }
+        }
+    }
+
+    if (drop == 0) {
+        state.out += width;
+    } else {
+        char* write = state.out;
+        for (unsigned i = 0; i < width; ++i) {
+            if (!((drop >> i) & 1)) {
+                *write++ = state.out[i];
+            }
+        }
+        state.out = write;
+    }
+
+    state.prev_space = (space_mask >> (width - 1)) & 1;
+}
+
+void normalize_scalar(const unsigned char* data, size_t size, KernelState& state) {
+    size_t pos = 0;
+    while (pos < size) {
+        unsigned width = static_cast<unsigned>(size - pos < 64 ? size - pos : 64);
+        uint64_t space_mask = 0;
+        for (unsigned i = 0; i < width; ++i) {
+            unsigned char c = data[pos + i];
+            state.out[i] = static_cast<char>(to_lower_byte(c));
+            space_mask |= static_cast<uint64_t>(is_space_byte(c)) << i;
+        }
+        finish_block(width, space_mask, state);
+        pos += width;
+    }
+}
+
+#ifdef TEXT_NORMALIZER_X86
+
+void normalize_sse2(const unsigned char* data, size_t size, KernelState& state) {
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i upper_a = _mm_set1_epi8('A');
+    const __m128i upper_range = _mm_set1_epi8(static_cast<char>(26 ^ 0x80));
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i control_range = _mm_set1_epi8(static_cast<char>(5 ^ 0x80));
+
+    size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+
+        __m128i is_upper = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(v, upper_a), sign), upper_range);
+        __m128i lowered = _mm_or_si128(v, _mm_and_si128(is_upper, case_bit));
+
+        __m128i is_control = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(v, tab), sign), control_range);
+        __m128i is_space = _mm_or_si128(_mm_cmpeq_epi8(v, space), is_control);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state.out), lowered);
+        finish_block(16, static_cast<uint32_t>(_mm_movemask_epi8(is_space)), state);
+    }
+
+    normalize_scalar(data + pos, size - pos, state);
+}
+
+__attribute__((target("avx2")))
+void normalize_avx2(const unsigned char* data, size_t size, KernelState& state) {
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i upper_a = _mm256_set1_epi8('A');
+    const __m256i upper_range = _mm256_set1_epi8(static_cast<char>(26 ^ 0x80));
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i control_range = _mm256_set1_epi8(static_cast<char>(5 ^ 0x80));
+
+    size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+
+        __m256i is_upper = _mm256_cmpgt_epi8(upper_range,
+            _mm256_xor_si256(_mm256_sub_epi8(v, upper_a), sign));
+        __m256i lowered = _mm256_or_si256(v, _mm256_and_si256(is_upper, case_bit));
+
+        __m256i is_control = _mm256_cmpgt_epi8(control_range,
+            _mm256_xor_si256(_mm256_sub_epi8(v, tab), sign));
+        __m256i is_space = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), is_control);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.out), lowered);
+        finish_block(32, static_cast<uint32_t>(_mm256_movemask_epi8(is_space)), state);
+    }
+
+    normalize_scalar(data + pos, size - pos, state);
+}
+
+#endif
+
+using Kernel = void (*)(const unsigned char*, size_t, KernelState&);
+
+struct KernelChoice {
+    Kernel kernel;
+    const char* name;
+};
+
+KernelChoice select_kernel() {
+#ifdef TEXT_NORMALIZER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {normalize_avx2, "avx2"};
+    }
+    return {normalize_sse2, "sse2"};
+#else
+    return {normalize_scalar, "scalar"};
+#endif
+}
+
+const KernelChoice& active_kernel() {
+    static const KernelChoice choice = select_kernel();
+    return choice;
+}
+
+}
+
+const std::string& TextNormalizer::normalize(const char* data, size_t size, bool collect_tokens) {
+    buffer.resize(size);
+    tokens.clear();
+    if (size == 0) {
+        return buffer;
+    }
+
+    KernelState state;
+    state.out_begin = &buffer[0];
+    state.out = state.out_begin;
+    state.prev_space = false;
+    state.in_token = !is_space_byte(static_cast<unsigned char>(data[0]));
+    state.token_start = 0;
+    state.tokens = collect_tokens ? &tokens : nullptr;
+
+    active_kernel().kernel(reinterpret_cast<const unsigned char*>(data), size, state);
+
+    auto length = static_cast<uint32_t>(state.out - state.out_begin);
+    if (collect_tokens && state.in_token) {
+        tokens.push_back({state.token_start, length - state.token_start});
+    }
+
+    buffer.resize(length);
+    return buffer;
+}
+
+const std::string& TextNormalizer::normalize(const std::string& text, bool collect_tokens) {
+    return normalize(text.data(), text.size(), collect_tokens);
+}
+
+const std::vector<TextNormalizer::Token>& TextNormalizer::last_tokens() const {
+    return tokens;
+}
+
+const char* TextNormalizer::kernel_name() {
+    return active_kernel().name;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Single-pass lowercase + whitespace collapse + tokenization. Produces the
+// same bytes as the legacy std::tolower/std::unique implementation: A-Z are
+// lowercased and every whitespace run keeps only its first character.
+// Picks an AVX2 or SSE2 kernel at runtime and falls back to scalar code.
+class TextNormalizer {
+public:
+    struct Token {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+private:
+    std::string buffer;
+    std::vector<Token> tokens;
+
+public:
+    const std::string& normalize(const char* data, size_t size, bool collect_tokens = false);
+    const std::string& normalize(const std::string& text, bool collect_tokens = false);
+
+    // Tokens of the last normalize() call made with collect_tokens = true,
+    // as offsets into the normalized buffer.
+    const std::vector<Token>& last_tokens() const;
+
+    static const char* kernel_name();
+};
@@ -0,0 +1,121 @@
+#include "work_cache.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+WorkCache::WorkCache(size_t capacity, std::chrono::milliseconds ttl, size_t shard_count)
+    : ttl(ttl) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("WorkCache: shard_count must be positive");
+    }
+
+    shard_capacity = std::max<size_t>(1, capacity / shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        id_shards.push_back(std::make_unique<IdShard>());
+        hash_shards.push_back(std::make_unique<HashShard>());
+    }
+}
+
+WorkCache::IdShard& WorkCache::shard_for(int work_id) {
+    return *id_shards[static_cast<size_t>(work_id) % id_shards.size()];
+}
+
+WorkCache::HashShard& WorkCache::shard_for(const std::string& file_hash) {
+    return *hash_shards[std::hash<std::string>{}(file_hash) % hash_shards.size()];
+}
+
+bool WorkCache::get(int work_id, Database::WorkInfo& info) {
+    IdShard& shard = shard_for(work_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.items.find(work_id);
+    if (it == shard.items.end()) {
+        return false;
+    }
+    if (it->second->expires_at <= Clock::now()) {
+        shard.order.erase(it->second);
+        shard.items.erase(it);
+        return false;
+    }
+
+    shard.order.splice(shard.order.begin(), shard.order, it->second);
+    info = it->second->info;
+    return true;
+}
+
+void WorkCache::put(const Database::WorkInfo& info) {
+    auto now = Clock::now();
+    {
+        IdShard& shard = shard_for(info.id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.items.find(info.id);
+        if (it != shard.items.end()) {
+            it->second->info = info;
+            it->second->expires_at = now + ttl;
+            shard.order.splice(shard.order.begin(), shard.order, it->second);
+        } else {
+            shard.order.push_front({info, now + ttl});
+            shard.items[info.id] = shard.order.begin();
+            if (shard.items.size() > shard_capacity) {
+                shard.items.erase(shard.order.back().info.id);
+                shard.order.pop_back();
+            }
+        }
+    }
+
+    HashShard& shard = shard_for(info.file_hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Hash entries are tiny, so expired ones are swept instead of kept in
+    // an LRU; the map never outgrows the id shards by much.
+    if (shard.items.size() >= shard_capacity && shard.items.count(info.file_hash) == 0) {
+        for (auto it = shard.items.begin(); it != shard.items.end();) {
+            it = it->second.expires_at <= now ? shard.items.erase(it) : std::next(it);
+        }
+        if (shard.items.size() >= shard_capacity) {
+            shard.items.erase(shard.items.begin());
+        }
+    }
+    shard.items[info.file_hash] = {info.id, now + ttl};
+}
+
+void WorkCache::invalidate(int work_id) {
+    IdShard& shard = shard_for(work_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.items.find(work_id);
+    if (it != shard.items.end()) {
+        shard.order.erase(it->second);
+        shard.items.erase(it);
+    }
+}
+
+bool WorkCache::get_by_hash(const std::string& file_hash, Database::WorkInfo& info) {
+    int work_id;
+    {
+        HashShard& shard = shard_for(file_hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.items.find(file_hash);
+        if (it == shard.items.end()) {
+            return false;
+        }
+        if (it->second.expires_at <= Clock::now()) {
+            shard.items.erase(it);
+            return false;
+        }
+        work_id = it->second.work_id;
+    }
+
+    return get(work_id, info);
+}
+
+size_t WorkCache::size() {
+    size_t total = 0;
+    for (auto& shard : id_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->items.size();
+    }
+    return total;
+}
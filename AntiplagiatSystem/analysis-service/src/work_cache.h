@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "database.h"
+
+// Bounded in-process cache of works rows, by id and by file hash. Entries
+// expire after a TTL, which bounds staleness from writes made by the file
+// service; writes made here invalidate explicitly. Keys are spread over
+// independently locked LRU shards so analysis workers rarely contend.
+class WorkCache {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        Database::WorkInfo info;
+        Clock::time_point expires_at;
+    };
+
+    struct IdShard {
+        std::mutex mutex;
+        std::list<Entry> order;
+        std::unordered_map<int, std::list<Entry>::iterator> items;
+    };
+
+    struct HashEntry {
+        int work_id;
+        Clock::time_point expires_at;
+    };
+
+    // file_hash -> id of the work holding it (file_hash is unique in works)
+    struct HashShard {
+        std::mutex mutex;
+        std::unordered_map<std::string, HashEntry> items;
+    };
+
+    std::vector<std::unique_ptr<IdShard>> id_shards;
+    std::vector<std::unique_ptr<HashShard>> hash_shards;
+    size_t shard_capacity;
+    std::chrono::milliseconds ttl;
+
+    IdShard& shard_for(int work_id);
+    HashShard& shard_for(const std::string& file_hash);
+
+public:
+    WorkCache(size_t capacity, std::chrono::milliseconds ttl, size_t shard_count = 16);
+
+    bool get(int work_id, Database::WorkInfo& info);
+    bool get_by_hash(const std::string& file_hash, Database::WorkInfo& info);
+    // Caches the row under its id and its file_hash.
+    void put(const Database::WorkInfo& info);
+    void invalidate(int work_id);
+
+    size_t size();
+};
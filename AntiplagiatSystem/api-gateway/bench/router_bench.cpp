@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+#include "router.h"
+
+namespace {
+
+// The matching the gateway did before the route table: a regex scan per
+// service followed by hand-written prefix rewriting.
+struct RegexRouter {
+    bool is_file_service_request(const std::string& path) const {
+        static const std::regex file_patterns[] = {
+            std::regex("^/api/files/.*"),
+            std::regex("^/api/upload"),
+            std::regex("^/api/upload/stream"),
+            std::regex("^/api/works")
+        };
+
+        for (const auto& pattern : file_patterns) {
+            if (std::regex_match(path, pattern)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool is_analysis_service_request(const std::string& path) const {
+        static const std::regex analysis_patterns[] = {
+            std::regex("^/api/reports/.*"),
+            std::regex("^/api/analyze"),
+            std::regex("^/api/analyze/assignment/.*"),
+            std::regex("^/api/jobs/.*")
+        };
+
+        for (const auto& pattern : analysis_patterns) {
+            if (std::regex_match(path, pattern)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool match(const std::string& path, std::string& target_path) const {
+        if (is_file_service_request(path) || is_analysis_service_request(path)) {
+            target_path = path.find("/api/") == 0 ? path.substr(4) : path;
+            return true;
+        }
+        return false;
+    }
+};
+
+const std::vector<std::string> PATHS = {
+    "/api/upload",
+    "/api/upload/stream",
+    "/api/files/42",
+    "/api/works",
+    "/api/reports/1234",
+    "/api/analyze",
+    "/api/analyze/assignment/hw-2",
+    "/api/jobs/1718000000000-17",
+    "/api/unknown/path",
+    "/favicon.ico"
+};
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+    Router router(default_routes());
+    RegexRouter regex_router;
+
+    for (const auto& path : PATHS) {
+        Router::Match match;
+        std::string regex_target;
+        bool trie_found = router.match(path, match);
+        bool regex_found = regex_router.match(path, regex_target);
+        if (trie_found != regex_found || (trie_found && match.target_path != regex_target)) {
+            std::cerr << "Mismatch for " << path << std::endl;
+            return 1;
+        }
+    }
+
+    size_t matched = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        Router::Match match;
+        matched += router.match(PATHS[i % PATHS.size()], match);
+    }
+    auto trie_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        std::string target_path;
+        matched += regex_router.match(PATHS[i % PATHS.size()], target_path);
+    }
+    auto regex_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Requests routed: " << iterations << " (" << matched << " matches)" << std::endl;
+    std::cout << "Trie:  " << trie_ns / iterations << " ns/request" << std::endl;
+    std::cout << "Regex: " << regex_ns / iterations << " ns/request" << std::endl;
+    std::cout << "Speedup: " << regex_ns / trie_ns << "x" << std::endl;
+    return 0;
+}
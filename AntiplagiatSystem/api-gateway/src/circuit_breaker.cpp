@@ -0,0 +1,98 @@
+#include "circuit_breaker.h"
+#include <iostream>
+
+CircuitBreaker::CircuitBreaker(unsigned failure_threshold, std::chrono::milliseconds cooldown)
+    : failure_threshold(failure_threshold == 0 ? 1 : failure_threshold),
+      cooldown(cooldown) {}
+
+void CircuitBreaker::trip(Clock::time_point now) {
+    if (state != State::Open) {
+        std::cout << "[API GATEWAY] Circuit opened (" << consecutive_failures
+                  << " consecutive failures)" << std::endl;
+    }
+    state = State::Open;
+    trial_in_flight = false;
+    open_until = now + cooldown;
+}
+
+bool CircuitBreaker::allow() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (state == State::Open) {
+        if (Clock::now() < open_until) {
+            return false;
+        }
+        state = State::HalfOpen;
+        trial_in_flight = false;
+    }
+
+    if (state == State::HalfOpen) {
+        if (trial_in_flight) {
+            return false;
+        }
+        trial_in_flight = true;
+    }
+
+    return true;
+}
+
+void CircuitBreaker::record_success() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == State::HalfOpen) {
+        std::cout << "[API GATEWAY] Circuit closed" << std::endl;
+    }
+    state = State::Closed;
+    consecutive_failures = 0;
+    trial_in_flight = false;
+}
+
+void CircuitBreaker::record_failure() {
+    std::lock_guard<std::mutex> lock(mutex);
+    consecutive_failures++;
+
+    if (state == State::HalfOpen || consecutive_failures >= failure_threshold) {
+        trip(Clock::now());
+    }
+}
+
+void CircuitBreaker::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == State::HalfOpen) {
+        trial_in_flight = false;
+    }
+}
+
+void CircuitBreaker::record_probe(bool available) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!available) {
+        trip(Clock::now());
+    } else if (state == State::Open) {
+        state = State::HalfOpen;
+        trial_in_flight = false;
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::current_state() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+int CircuitBreaker::retry_after_seconds() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::Open) {
+        return 1;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
+        open_until - Clock::now() + std::chrono::milliseconds(999)).count();
+    return remaining > 1 ? static_cast<int>(remaining) : 1;
+}
+
+const char* CircuitBreaker::state_name(State state) {
+    switch (state) {
+        case State::Open: return "open";
+        case State::HalfOpen: return "half_open";
+        default: return "closed";
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+
+// Per-upstream breaker. Closed passes traffic and counts consecutive failures;
+// Open rejects everything until the cooldown ends (or a health probe succeeds);
+// HalfOpen lets a single trial request through and closes again on success.
+class CircuitBreaker {
+public:
+    enum class State {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    unsigned failure_threshold;
+    std::chrono::milliseconds cooldown;
+
+    mutable std::mutex mutex;
+    State state = State::Closed;
+    unsigned consecutive_failures = 0;
+    bool trial_in_flight = false;
+    Clock::time_point open_until;
+
+    void trip(Clock::time_point now);
+
+public:
+    explicit CircuitBreaker(unsigned failure_threshold = 5,
+                            std::chrono::milliseconds cooldown = std::chrono::seconds(10));
+
+    bool allow();
+    void record_success();
+    void record_failure();
+    // Releases a slot taken by allow() when the request was never sent.
+    void cancel();
+    // Health probe results: an unavailable upstream trips the breaker, a
+    // healthy one lets an open breaker move to half-open before the cooldown.
+    void record_probe(bool available);
+
+    State current_state() const;
+    int retry_after_seconds() const;
+
+    static const char* state_name(State state);
+};
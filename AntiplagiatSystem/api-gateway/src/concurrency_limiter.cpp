@@ -0,0 +1,96 @@
+#include "concurrency_limiter.h"
+#include <algorithm>
+
+namespace {
+// Baseline latency drifts towards new samples slowly so that a brief spike
+// does not become the new normal.
+const double BASELINE_DECAY = 0.05;
+}
+
+ConcurrencyLimiter::ConcurrencyLimiter(unsigned initial_limit,
+                                       unsigned min_limit,
+                                       unsigned max_limit,
+                                       double backoff,
+                                       double latency_tolerance)
+    : min_limit(min_limit == 0 ? 1 : min_limit),
+      max_limit(std::max(max_limit, min_limit)),
+      backoff(backoff),
+      latency_tolerance(latency_tolerance),
+      limit(std::clamp<double>(initial_limit, this->min_limit, this->max_limit)) {}
+
+bool ConcurrencyLimiter::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (in_flight >= static_cast<unsigned>(limit)) {
+        return false;
+    }
+    in_flight++;
+    return true;
+}
+
+void ConcurrencyLimiter::decrease(std::chrono::steady_clock::time_point now) {
+    // One cut per baseline round trip: a burst of failures from the same
+    // overload episode should not collapse the limit to the floor.
+    auto window = std::chrono::milliseconds(static_cast<long>(std::max(baseline_ms, 50.0)));
+    if (now - last_decrease < window) {
+        return;
+    }
+    last_decrease = now;
+    limit = std::max(min_limit, limit * backoff);
+}
+
+void ConcurrencyLimiter::release(std::chrono::milliseconds latency, bool failed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (in_flight > 0) {
+        in_flight--;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double sample = static_cast<double>(latency.count());
+
+    if (failed) {
+        decrease(now);
+        return;
+    }
+
+    if (baseline_ms <= 0.0) {
+        baseline_ms = sample;
+    } else if (sample < baseline_ms) {
+        baseline_ms = sample;
+    } else {
+        baseline_ms += (sample - baseline_ms) * BASELINE_DECAY;
+    }
+
+    if (sample > baseline_ms * latency_tolerance && sample > 5.0) {
+        decrease(now);
+    } else if (in_flight + 1 >= static_cast<unsigned>(limit) / 2) {
+        // Only grow while the limit is actually being used.
+        limit = std::min(max_limit, limit + 1.0 / limit);
+    }
+}
+
+void ConcurrencyLimiter::release_unsampled(bool failed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (in_flight > 0) {
+        in_flight--;
+    }
+    if (failed) {
+        decrease(std::chrono::steady_clock::now());
+    }
+}
+
+void ConcurrencyLimiter::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (in_flight > 0) {
+        in_flight--;
+    }
+}
+
+unsigned ConcurrencyLimiter::current_limit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<unsigned>(limit);
+}
+
+unsigned ConcurrencyLimiter::current_in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return in_flight;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+
+// AIMD limit on in-flight requests to one upstream. The limit grows by one
+// per window of successful requests whose latency stays near the observed
+// baseline, and is cut multiplicatively on failures or when latency climbs,
+// so an overloaded upstream sees less queueing instead of more.
+class ConcurrencyLimiter {
+private:
+    double min_limit;
+    double max_limit;
+    double backoff;
+    double latency_tolerance;
+
+    mutable std::mutex mutex;
+    double limit;
+    unsigned in_flight = 0;
+    double baseline_ms = 0.0;
+    std::chrono::steady_clock::time_point last_decrease;
+
+    void decrease(std::chrono::steady_clock::time_point now);
+
+public:
+    explicit ConcurrencyLimiter(unsigned initial_limit = 32,
+                                unsigned min_limit = 4,
+                                unsigned max_limit = 512,
+                                double backoff = 0.8,
+                                double latency_tolerance = 2.0);
+
+    bool try_acquire();
+    // Returns the slot and feeds the observed latency into the limit.
+    void release(std::chrono::milliseconds latency, bool failed);
+    // Returns the slot of a request whose latency is not a load signal;
+    // a failure still cuts the limit.
+    void release_unsampled(bool failed);
+    // Returns the slot without a sample, for requests that were never sent.
+    void cancel();
+
+    unsigned current_limit() const;
+    unsigned current_in_flight() const;
+};
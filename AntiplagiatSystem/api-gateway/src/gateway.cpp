@@ -1,18 +1,76 @@
 #include "gateway.h"
 #include <iostream>
-#include <regex>
 #include <ctime>
 
 using namespace utility;
 
+namespace {
+const size_t REPORT_CACHE_ENTRIES = 4096;
+const size_t REPORT_CACHE_BYTES = 64 * 1024 * 1024;
+const size_t REPORT_CACHE_MAX_ENTRY = 1024 * 1024;
+const auto REPORT_CACHE_TTL = std::chrono::minutes(10);
+const auto JOB_POLL_INTERVAL = std::chrono::milliseconds(500);
+const size_t JOB_POLL_BATCH = 32;
+const char REPORT_PATH_PREFIX[] = "/reports/";
+
+bool etag_matches(const utility::string_t& header, const utility::string_t& etag) {
+    if (header == U("*")) {
+        return true;
+    }
+
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t comma = header.find(U(','), pos);
+        utility::string_t candidate = header.substr(pos, comma == utility::string_t::npos ?
+                                                          utility::string_t::npos : comma - pos);
+        size_t begin = candidate.find_first_not_of(U(" \t"));
+        size_t end = candidate.find_last_not_of(U(" \t"));
+        if (begin != utility::string_t::npos) {
+            candidate = candidate.substr(begin, end - begin + 1);
+            if (candidate.compare(0, 2, U("W/")) == 0) {
+                candidate = candidate.substr(2);
+            }
+            if (candidate == etag) {
+                return true;
+            }
+        }
+        if (comma == utility::string_t::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+
+    return false;
+}
+}
+
 APIGateway::APIGateway(const std::string& url,
                        const std::string& file_service_url,
-                       const std::string& analysis_service_url)
+                       const std::string& analysis_service_url,
+                       std::chrono::milliseconds probe_interval)
     : listener(conversions::to_string_t(url)),
       file_service_url(file_service_url),
       analysis_service_url(analysis_service_url),
       file_client(conversions::to_string_t(file_service_url)),
-      analysis_client(conversions::to_string_t(analysis_service_url)) {
+      analysis_client(conversions::to_string_t(analysis_service_url)),
+      router(default_routes()),
+      prober(file_service_url, analysis_service_url, probe_interval),
+      report_cache(REPORT_CACHE_ENTRIES, REPORT_CACHE_BYTES, REPORT_CACHE_MAX_ENTRY, REPORT_CACHE_TTL),
+      job_watcher(analysis_service_url, JOB_POLL_INTERVAL, JOB_POLL_BATCH) {
+
+    prober.set_listener([this](Router::Upstream upstream, const HealthProber::Status& status) {
+        if (!prober.is_available(upstream)) {
+            guard_for(upstream).breaker.record_probe(false);
+        } else if (status.state == HealthProber::State::Healthy) {
+            guard_for(upstream).breaker.record_probe(true);
+        }
+    });
+
+    // A report held for a queued analysis becomes cacheable again once the
+    // job has finished and the new report is in the database.
+    job_watcher.set_listener([this](const std::string& cache_key) {
+        report_cache.release(cache_key);
+    });
 
     listener.support([this](http_request request) {
         handle_request(request);
@@ -29,6 +87,8 @@ APIGateway::~APIGateway() {
 
 void APIGateway::start() {
     try {
+        prober.start();
+        job_watcher.start();
         listener.open().wait();
         std::cout << "[API GATEWAY] Listening on: " << conversions::to_utf8string(listener.uri().to_string()) << std::endl;
     } catch (const std::exception& e) {
@@ -39,6 +99,8 @@ void APIGateway::start() {
 
 void APIGateway::stop() {
     listener.close().wait();
+    prober.stop();
+    job_watcher.stop();
     std::cout << "[API GATEWAY] Stopped" << std::endl;
 }
 
@@ -61,14 +123,20 @@ void APIGateway::handle_request(http_request request) {
             return;
         }
 
-        if (is_file_service_request(path_str)) {
-            route_to_file_service(request);
-        } else if (is_analysis_service_request(path_str)) {
-            route_to_analysis_service(request);
-        } else {
+        Router::Match match;
+        if (!router.match(path_str, match)) {
             send_error_response(request, status_codes::NotFound,
                 "not_found", "Endpoint not found");
+            return;
+        }
+
+        if (!match.route->allows(conversions::to_utf8string(request.method()))) {
+            send_error_response(request, status_codes::MethodNotAllowed,
+                "method_not_allowed", "Method not allowed for this endpoint");
+            return;
         }
+
+        route_to_upstream(request, match);
         
     } catch (const std::exception& e) {
         std::cerr << "[API GATEWAY ERROR] Handle request: " << e.what() << std::endl;
@@ -78,128 +146,247 @@ void APIGateway::handle_request(http_request request) {
 }
 
 void APIGateway::handle_health(http_request request) {
+    auto describe = [this](Router::Upstream upstream) {
+        HealthProber::Status status = prober.status(upstream);
+        UpstreamGuard& guard = guard_for(upstream);
+
+        json::value details;
+        details[U("status")] = json::value::string(
+            conversions::to_string_t(HealthProber::state_name(status.state)));
+        details[U("latency_ms")] = json::value::number(status.latency_us / 1000.0);
+        details[U("consecutive_failures")] = json::value::number(status.consecutive_failures);
+        details[U("checked_at")] = json::value::number(static_cast<int64_t>(status.checked_at));
+        details[U("circuit")] = json::value::string(
+            conversions::to_string_t(CircuitBreaker::state_name(guard.breaker.current_state())));
+        details[U("concurrency_limit")] = json::value::number(guard.limiter.current_limit());
+        details[U("in_flight")] = json::value::number(guard.limiter.current_in_flight());
+        return details;
+    };
+
+    json::value file_service = describe(Router::Upstream::FileService);
+    json::value analysis_service = describe(Router::Upstream::AnalysisService);
+
     json::value response;
     response[U("service")] = json::value::string(U("api-gateway"));
     response[U("status")] = json::value::string(U("healthy"));
     response[U("timestamp")] = json::value::string(
         conversions::to_string_t(std::to_string(std::time(nullptr)))
     );
+    response[U("file_service")] = file_service[U("status")];
+    response[U("analysis_service")] = analysis_service[U("status")];
+    response[U("upstreams")][U("file_service")] = file_service;
+    response[U("upstreams")][U("analysis_service")] = analysis_service;
+    response[U("report_cache_entries")] = json::value::number(static_cast<uint64_t>(report_cache.size()));
+    response[U("watched_jobs")] = json::value::number(static_cast<uint64_t>(job_watcher.size()));
 
-    try {
-        auto file_response = file_client.request(methods::GET, U("/health")).get();
-        response[U("file_service")] = json::value::string(
-            file_response.status_code() == status_codes::OK ? U("healthy") : U("unhealthy"));
-    } catch (...) {
-        response[U("file_service")] = json::value::string(U("unreachable"));
-    }
-    
-    try {
-        auto analysis_response = analysis_client.request(methods::GET, U("/health")).get();
-        response[U("analysis_service")] = json::value::string(
-            analysis_response.status_code() == status_codes::OK ? U("healthy") : U("unhealthy"));
-    } catch (...) {
-        response[U("analysis_service")] = json::value::string(U("unreachable"));
-    }
-    
     http_response http_resp(status_codes::OK);
     http_resp.set_body(response);
     http_resp.headers().add(U("Content-Type"), U("application/json"));
     send_response(request, http_resp);
 }
 
-void APIGateway::route_to_file_service(http_request request) {
-    try {
-        auto target_path = request.relative_uri().path();
+void APIGateway::route_to_upstream(http_request request, const Router::Match& match) {
+    Router::Upstream upstream = match.route->upstream;
+    std::string service_name = Router::upstream_name(upstream);
 
-        std::string path_str = conversions::to_utf8string(target_path);
-        if (path_str.find("/api/files") == 0) {
-            path_str = path_str.substr(4); 
-        }
-        
+    try {
         http_request proxy_request(request.method());
-        proxy_request.set_request_uri(conversions::to_string_t(path_str));
+        uri_builder proxy_uri(conversions::to_string_t(match.target_path));
+        proxy_uri.set_query(request.request_uri().query());
+        proxy_request.set_request_uri(proxy_uri.to_uri());
 
         for (const auto& header : request.headers()) {
             proxy_request.headers().add(header.first, header.second);
         }
 
+        Router::CachePolicy cache = match.route->cache;
+        if (cache == Router::CachePolicy::Store && request.method() == methods::GET) {
+            auto cached = report_cache.get(match.target_path);
+            if (cached) {
+                reply_cached(request, *cached, U("HIT"));
+                return;
+            }
+            std::string cache_key = match.target_path;
+            uint64_t generation = report_cache.generation(cache_key);
+            proxy(request, *match.route, proxy_request,
+                  [this, cache_key, generation](http_request request, http_response response) {
+                      store_and_reply(request, response, cache_key, generation);
+                  });
+            return;
+        }
+
         if (request.method() == methods::POST || request.method() == methods::PUT) {
-            proxy_request.set_body(request.extract_json().get());
+            forward_body(request, proxy_request);
         }
 
-        auto response = file_client.request(proxy_request).get();
+        if (cache == Router::CachePolicy::Invalidate && request.method() == methods::POST) {
+            proxy(request, *match.route, proxy_request, [this](http_request request, http_response response) {
+                hold_and_reply(request, response);
+            });
+            return;
+        }
 
-        send_response(request, response);
+        proxy(request, *match.route, proxy_request, [this](http_request request, http_response response) {
+            send_response(request, response);
+        });
         
     } catch (const std::exception& e) {
-        std::cerr << "[API GATEWAY ERROR] File service routing: " << e.what() << std::endl;
+        std::cerr << "[API GATEWAY ERROR] " << service_name << " routing: " << e.what() << std::endl;
         send_error_response(request, status_codes::BadGateway,
-            "service_unavailable", "File service is unavailable");
+            "service_unavailable", service_name + " is unavailable");
     }
 }
 
-void APIGateway::route_to_analysis_service(http_request request) {
-    try {
-        auto target_path = request.relative_uri().path();
+void APIGateway::forward_body(http_request request, http_request& proxy_request) {
+    auto content_type = request.headers().content_type();
+    if (content_type.empty()) {
+        content_type = U("application/octet-stream");
+    }
+    proxy_request.set_body(request.body(), content_type);
+}
 
-        std::string path_str = conversions::to_utf8string(target_path);
-        if (path_str.find("/api/reports") == 0) {
-            path_str = path_str.substr(4);
-        } else if (path_str.find("/api/analyze") == 0) {
-            path_str = "/analyze";
-        }
-        
-        http_request proxy_request(request.method());
-        proxy_request.set_request_uri(conversions::to_string_t(path_str));
+APIGateway::UpstreamGuard& APIGateway::guard_for(Router::Upstream upstream) {
+    return guards[static_cast<size_t>(upstream)];
+}
 
-        for (const auto& header : request.headers()) {
-            proxy_request.headers().add(header.first, header.second);
-        }
+http_client& APIGateway::client_for(Router::Upstream upstream) {
+    return upstream == Router::Upstream::FileService ? file_client : analysis_client;
+}
 
-        if (request.method() == methods::POST) {
-            proxy_request.set_body(request.extract_json().get());
-        }
+void APIGateway::store_and_reply(http_request request, http_response response,
+                                 const std::string& cache_key, uint64_t generation) {
+    if (response.status_code() != status_codes::OK) {
+        send_response(request, response);
+        return;
+    }
 
-        auto response = analysis_client.request(proxy_request).get();
+    std::string content_type = conversions::to_utf8string(response.headers().content_type());
+    response.extract_vector()
+        .then([this, request, cache_key, content_type, generation](pplx::task<std::vector<unsigned char>> body_task) {
+            try {
+                auto entry = report_cache.put(cache_key, body_task.get(), content_type, generation);
+                reply_cached(request, *entry, U("MISS"));
+            } catch (const std::exception& e) {
+                std::cerr << "[API GATEWAY ERROR] Read upstream body: " << e.what() << std::endl;
+                send_error_response(request, status_codes::BadGateway,
+                    "service_unavailable", "Upstream response was interrupted");
+            }
+        });
+}
 
+void APIGateway::hold_and_reply(http_request request, http_response response) {
+    if (response.status_code() != status_codes::Accepted) {
         send_response(request, response);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "[API GATEWAY ERROR] Analysis service routing: " << e.what() << std::endl;
-        send_error_response(request, status_codes::BadGateway,
-            "service_unavailable", "Analysis service is unavailable");
+        return;
     }
+
+    // The 202 names the queued job and its work: the cached report is held
+    // until the watcher sees that job finish, however long the queue is.
+    response.extract_json()
+        .then([this, request](pplx::task<json::value> body_task) {
+            try {
+                json::value data = body_task.get();
+                if (data.has_field(U("job_id")) && data[U("job_id")].is_string() &&
+                    data.has_field(U("work_id")) && data[U("work_id")].is_integer()) {
+                    std::string cache_key = REPORT_PATH_PREFIX + std::to_string(data[U("work_id")].as_integer());
+                    report_cache.hold(cache_key);
+                    job_watcher.watch(conversions::to_utf8string(data[U("job_id")].as_string()), cache_key);
+                }
+
+                http_response reply(status_codes::Accepted);
+                reply.set_body(data);
+                send_response(request, reply);
+            } catch (const std::exception& e) {
+                std::cerr << "[API GATEWAY ERROR] Read upstream body: " << e.what() << std::endl;
+                send_error_response(request, status_codes::BadGateway,
+                    "service_unavailable", "Upstream response was interrupted");
+            }
+        });
 }
 
-bool APIGateway::is_file_service_request(const std::string& path) {
-    static const std::regex file_patterns[] = {
-        std::regex("^/api/files/.*"),
-        std::regex("^/api/upload"),
-        std::regex("^/api/works")
-    };
-    
-    for (const auto& pattern : file_patterns) {
-        if (std::regex_match(path, pattern)) {
-            return true;
-        }
+void APIGateway::reply_cached(http_request request, const ResponseCache::Entry& entry,
+                              const utility::string_t& cache_status) {
+    utility::string_t etag = conversions::to_string_t(entry.etag);
+
+    auto if_none_match = request.headers().find(U("If-None-Match"));
+    if (if_none_match != request.headers().end() && etag_matches(if_none_match->second, etag)) {
+        http_response response(status_codes::NotModified);
+        response.headers().add(U("ETag"), etag);
+        response.headers().add(U("X-Cache"), cache_status);
+        send_response(request, response);
+        return;
     }
-    
-    return false;
+
+    http_response response(status_codes::OK);
+    response.set_body(entry.body);
+    if (!entry.content_type.empty()) {
+        response.headers().set_content_type(conversions::to_string_t(entry.content_type));
+    }
+    response.headers().add(U("ETag"), etag);
+    response.headers().add(U("X-Cache"), cache_status);
+    send_response(request, response);
 }
 
-bool APIGateway::is_analysis_service_request(const std::string& path) {
-    static const std::regex analysis_patterns[] = {
-        std::regex("^/api/reports/.*"),
-        std::regex("^/api/analyze")
-    };
-    
-    for (const auto& pattern : analysis_patterns) {
-        if (std::regex_match(path, pattern)) {
-            return true;
-        }
+void APIGateway::proxy(http_request request, const Router::Route& route, http_request proxy_request,
+                       ResponseHandler on_response) {
+    Router::Upstream upstream = route.upstream;
+    UpstreamGuard& guard = guard_for(upstream);
+    std::string service_name = Router::upstream_name(upstream);
+    bool sample_latency = route.sample_latency;
+
+    // Shed load before anything is queued: an exhausted concurrency limit or
+    // an open circuit is answered at once with 503 and a retry hint.
+    if (!guard.limiter.try_acquire()) {
+        send_unavailable(request, service_name, 1);
+        return;
     }
-    
-    return false;
+    if (!guard.breaker.allow()) {
+        guard.limiter.cancel();
+        send_unavailable(request, service_name, guard.breaker.retry_after_seconds());
+        return;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+
+    pplx::task<http_response> sent;
+    try {
+        sent = client_for(upstream).request(proxy_request);
+    } catch (const std::exception&) {
+        // The request never left, so neither the concurrency slot nor a
+        // half-open trial may stay taken; the caller answers with 502.
+        guard.limiter.cancel();
+        guard.breaker.cancel();
+        throw;
+    }
+
+    sent
+        .then([this, request, service_name, &guard, started, sample_latency, on_response](pplx::task<http_response> response_task) {
+            bool failed = false;
+            try {
+                http_response response = response_task.get();
+                failed = response.status_code() >= 500;
+
+                on_response(request, response);
+            } catch (const std::exception& e) {
+                failed = true;
+                std::cerr << "[API GATEWAY ERROR] " << service_name << " routing: " << e.what() << std::endl;
+                send_error_response(request, status_codes::BadGateway,
+                    "service_unavailable", service_name + " is unavailable");
+            }
+
+            if (sample_latency) {
+                auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - started);
+                guard.limiter.release(latency, failed);
+            } else {
+                guard.limiter.release_unsampled(failed);
+            }
+            if (failed) {
+                guard.breaker.record_failure();
+            } else {
+                guard.breaker.record_success();
+            }
+        });
 }
 
 void APIGateway::send_response(http_request request, http_response response) {
@@ -221,9 +408,25 @@ void APIGateway::send_error_response(http_request request, status_code status,
     request.reply(http_resp);
 }
 
+void APIGateway::send_unavailable(http_request request, const std::string& service_name, int retry_after) {
+    json::value response;
+    response[U("error")] = json::value::string(U("service_unavailable"));
+    response[U("message")] = json::value::string(
+        conversions::to_string_t(service_name + " is temporarily unavailable"));
+
+    http_response http_resp(status_codes::ServiceUnavailable);
+    http_resp.set_body(response);
+    http_resp.headers().add(U("Content-Type"), U("application/json"));
+    http_resp.headers().add(U("Retry-After"), conversions::to_string_t(std::to_string(retry_after)));
+
+    add_cors_headers(http_resp);
+    request.reply(http_resp);
+}
+
 void APIGateway::add_cors_headers(http_response& response) {
     response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
     response.headers().add(U("Access-Control-Allow-Methods"), U("GET, POST, PUT, DELETE, OPTIONS"));
-    response.headers().add(U("Access-Control-Allow-Headers"), U("Content-Type, Authorization"));
+    response.headers().add(U("Access-Control-Allow-Headers"), U("Content-Type, Authorization, If-None-Match"));
+    response.headers().add(U("Access-Control-Expose-Headers"), U("ETag, X-Cache, Retry-After"));
     response.headers().add(U("Access-Control-Max-Age"), U("86400"));
 }
\ No newline at end of file
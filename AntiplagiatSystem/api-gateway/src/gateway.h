@@ -2,8 +2,17 @@
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
 #include <cpprest/http_client.h>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <map>
+#include <vector>
+#include "router.h"
+#include "health_prober.h"
+#include "circuit_breaker.h"
+#include "concurrency_limiter.h"
+#include "response_cache.h"
+#include "job_watcher.h"
 
 using namespace web;
 using namespace web::http;
@@ -19,11 +28,23 @@ private:
 
     http_client file_client;
     http_client analysis_client;
+
+    struct UpstreamGuard {
+        CircuitBreaker breaker;
+        ConcurrencyLimiter limiter;
+    };
+
+    Router router;
+    HealthProber prober;
+    UpstreamGuard guards[HealthProber::UPSTREAM_COUNT];
+    ResponseCache report_cache;
+    JobWatcher job_watcher;
     
 public:
     APIGateway(const std::string& url, 
                const std::string& file_service_url,
-               const std::string& analysis_service_url);
+               const std::string& analysis_service_url,
+               std::chrono::milliseconds probe_interval = std::chrono::seconds(2));
     ~APIGateway();
     
     void start();
@@ -33,15 +54,27 @@ private:
     void handle_request(http_request request);
     void handle_health(http_request request);
 
-    void route_to_file_service(http_request request);
-    void route_to_analysis_service(http_request request);
+    void route_to_upstream(http_request request, const Router::Match& match);
+
+    // Proxy calls are chained as continuations so no pool thread waits on an
+    // upstream. Request bodies are forwarded as opaque streams, never parsed.
+    void forward_body(http_request request, http_request& proxy_request);
+    // on_response runs on the upstream's reply and must answer the client.
+    using ResponseHandler = std::function<void(http_request, http_response)>;
+    void proxy(http_request request, const Router::Route& route, http_request proxy_request,
+               ResponseHandler on_response);
+    void store_and_reply(http_request request, http_response response,
+                         const std::string& cache_key, uint64_t generation);
+    void hold_and_reply(http_request request, http_response response);
+    void reply_cached(http_request request, const ResponseCache::Entry& entry, const utility::string_t& cache_status);
+
+    UpstreamGuard& guard_for(Router::Upstream upstream);
+    http_client& client_for(Router::Upstream upstream);
 
-    bool is_file_service_request(const std::string& path);
-    bool is_analysis_service_request(const std::string& path);
-    
     void send_response(http_request request, http_response response);
     void send_error_response(http_request request, status_code status,
                             const std::string& error, const std::string& message);
+    void send_unavailable(http_request request, const std::string& service_name, int retry_after);
     
     void add_cors_headers(http_response& response);
 };
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "health_prober.h"
+#include <iostream>
+#include <utility>
+
+using namespace web;
+using namespace web::http;
+using namespace web::http::client;
+
+namespace {
+const uint16_t FAILURE_THRESHOLD = 3;
+
+http_client_config probe_config(std::chrono::milliseconds interval) {
+    http_client_config config;
+    config.set_timeout(std::chrono::duration_cast<std::chrono::microseconds>(interval));
+    return config;
+}
+
+size_t slot_index(Router::Upstream upstream) {
+    return static_cast<size_t>(upstream);
+}
+}
+
+HealthProber::HealthProber(const std::string& file_service_url,
+                           const std::string& analysis_service_url,
+                           std::chrono::milliseconds interval)
+    : file_client(utility::conversions::to_string_t(file_service_url), probe_config(interval)),
+      analysis_client(utility::conversions::to_string_t(analysis_service_url), probe_config(interval)),
+      interval(interval) {}
+
+HealthProber::~HealthProber() {
+    stop();
+}
+
+void HealthProber::set_listener(Listener listener) {
+    this->listener = std::move(listener);
+}
+
+void HealthProber::start() {
+    worker = std::thread(&HealthProber::run, this);
+}
+
+void HealthProber::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void HealthProber::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    while (!stopping) {
+        lock.unlock();
+        try {
+            probe_all();
+        } catch (const std::exception& e) {
+            std::cerr << "[API GATEWAY ERROR] Health probe: " << e.what() << std::endl;
+        }
+        lock.lock();
+
+        stop_cv.wait_for(lock, interval, [this] { return stopping; });
+    }
+}
+
+void HealthProber::probe_all() {
+    auto probe = [](http_client& client) {
+        auto started = std::chrono::steady_clock::now();
+        return client.request(methods::GET, U("/health"))
+            .then([started](pplx::task<http_response> response_task) {
+                State state;
+                try {
+                    state = response_task.get().status_code() == status_codes::OK
+                        ? State::Healthy : State::Unhealthy;
+                } catch (...) {
+                    state = State::Unreachable;
+                }
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+                return std::make_pair(state, static_cast<uint32_t>(elapsed));
+            });
+    };
+
+    // Both probes are in flight at once; this thread is the only one waiting.
+    auto file_probe = probe(file_client);
+    auto analysis_probe = probe(analysis_client);
+
+    auto file_result = file_probe.get();
+    record(Router::Upstream::FileService, file_result.first, file_result.second);
+
+    auto analysis_result = analysis_probe.get();
+    record(Router::Upstream::AnalysisService, analysis_result.first, analysis_result.second);
+}
+
+uint64_t HealthProber::pack(State state, uint16_t failures, uint32_t latency_us) {
+    return (static_cast<uint64_t>(state) << 48) |
+           (static_cast<uint64_t>(failures) << 32) |
+           latency_us;
+}
+
+void HealthProber::record(Router::Upstream upstream, State state, uint32_t latency_us) {
+    Slot& slot = slots[slot_index(upstream)];
+
+    Status previous = status(upstream);
+    uint16_t failures = 0;
+    if (state != State::Healthy) {
+        failures = previous.consecutive_failures == UINT16_MAX
+            ? previous.consecutive_failures : previous.consecutive_failures + 1;
+    }
+
+    if (state != previous.state) {
+        std::cout << "[API GATEWAY] " << Router::upstream_name(upstream) << " is "
+                  << state_name(state) << std::endl;
+    }
+
+    slot.checked_at.store(std::time(nullptr), std::memory_order_relaxed);
+    slot.packed.store(pack(state, failures, latency_us), std::memory_order_release);
+
+    if (listener) {
+        listener(upstream, status(upstream));
+    }
+}
+
+HealthProber::Status HealthProber::status(Router::Upstream upstream) const {
+    const Slot& slot = slots[slot_index(upstream)];
+    uint64_t packed = slot.packed.load(std::memory_order_acquire);
+
+    Status result;
+    result.state = static_cast<State>((packed >> 48) & 0xFF);
+    result.consecutive_failures = static_cast<uint16_t>((packed >> 32) & 0xFFFF);
+    result.latency_us = static_cast<uint32_t>(packed & 0xFFFFFFFF);
+    result.checked_at = static_cast<std::time_t>(slot.checked_at.load(std::memory_order_relaxed));
+    return result;
+}
+
+bool HealthProber::is_available(Router::Upstream upstream) const {
+    return status(upstream).consecutive_failures < FAILURE_THRESHOLD;
+}
+
+const char* HealthProber::state_name(State state) {
+    switch (state) {
+        case State::Healthy: return "healthy";
+        case State::Unhealthy: return "unhealthy";
+        case State::Unreachable: return "unreachable";
+        default: return "unknown";
+    }
+}
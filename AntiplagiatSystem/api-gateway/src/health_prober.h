@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cpprest/http_client.h>
+#include "router.h"
+
+// Polls every upstream's /health on a fixed interval from a background thread.
+// The latest result per upstream is packed into a single atomic word, so
+// readers get a consistent status without taking a lock.
+class HealthProber {
+public:
+    enum class State : uint8_t {
+        Unknown,
+        Healthy,
+        Unhealthy,
+        Unreachable
+    };
+
+    struct Status {
+        State state = State::Unknown;
+        uint16_t consecutive_failures = 0;
+        uint32_t latency_us = 0;
+        std::time_t checked_at = 0;
+    };
+
+    static const size_t UPSTREAM_COUNT = 2;
+
+    using Listener = std::function<void(Router::Upstream, const Status&)>;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> packed{0};
+        std::atomic<int64_t> checked_at{0};
+    };
+
+    web::http::client::http_client file_client;
+    web::http::client::http_client analysis_client;
+    std::chrono::milliseconds interval;
+
+    Slot slots[UPSTREAM_COUNT];
+    Listener listener;
+
+    std::thread worker;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+
+    static uint64_t pack(State state, uint16_t failures, uint32_t latency_us);
+    void run();
+    void probe_all();
+    void record(Router::Upstream upstream, State state, uint32_t latency_us);
+
+public:
+    HealthProber(const std::string& file_service_url,
+                 const std::string& analysis_service_url,
+                 std::chrono::milliseconds interval);
+    ~HealthProber();
+
+    // Called from the probe thread after every probe; set before start().
+    void set_listener(Listener listener);
+
+    void start();
+    void stop();
+
+    Status status(Router::Upstream upstream) const;
+    // False once an upstream failed several probes in a row; the gateway
+    // opens that upstream's circuit breaker on it.
+    bool is_available(Router::Upstream upstream) const;
+
+    static const char* state_name(State state);
+};
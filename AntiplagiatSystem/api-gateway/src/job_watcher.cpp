@@ -0,0 +1,137 @@
+#include "job_watcher.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace web;
+using namespace web::http;
+using namespace web::http::client;
+
+namespace {
+http_client_config poll_config(std::chrono::milliseconds interval) {
+    http_client_config config;
+    config.set_timeout(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::max(interval, std::chrono::milliseconds(1000))));
+    return config;
+}
+}
+
+JobWatcher::JobWatcher(const std::string& analysis_service_url,
+                       std::chrono::milliseconds interval,
+                       size_t batch_size)
+    : client(utility::conversions::to_string_t(analysis_service_url), poll_config(interval)),
+      interval(interval),
+      batch_size(batch_size == 0 ? 1 : batch_size) {}
+
+JobWatcher::~JobWatcher() {
+    stop();
+}
+
+void JobWatcher::set_listener(Listener listener) {
+    this->listener = std::move(listener);
+}
+
+void JobWatcher::watch(const std::string& job_id, const std::string& cache_key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    watched.push_back({job_id, cache_key});
+}
+
+void JobWatcher::start() {
+    worker = std::thread(&JobWatcher::run, this);
+}
+
+void JobWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+size_t JobWatcher::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return watched.size();
+}
+
+void JobWatcher::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    while (!stopping) {
+        lock.unlock();
+        try {
+            poll();
+        } catch (const std::exception& e) {
+            std::cerr << "[API GATEWAY ERROR] Job watcher: " << e.what() << std::endl;
+        }
+        lock.lock();
+
+        stop_cv.wait_for(lock, interval, [this] { return stopping; });
+    }
+}
+
+void JobWatcher::poll() {
+    // Jobs run in queue order, so the oldest watches are polled first; the
+    // ones still running go to the back and the rest get their turn.
+    std::vector<Watch> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = std::min(batch_size, watched.size());
+        batch.assign(std::make_move_iterator(watched.begin()),
+                     std::make_move_iterator(watched.begin() + count));
+        watched.erase(watched.begin(), watched.begin() + count);
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    // All requests of the batch are in flight at once; only this thread waits.
+    std::vector<pplx::task<http_response>> requests;
+    requests.reserve(batch.size());
+    for (const Watch& watch : batch) {
+        requests.push_back(client.request(methods::GET,
+                                          utility::conversions::to_string_t("/jobs/" + watch.job_id)));
+    }
+
+    std::vector<Watch> unfinished;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (outcome(requests[i]) == Outcome::Finished) {
+            if (listener) {
+                listener(batch[i].cache_key);
+            }
+        } else {
+            unfinished.push_back(std::move(batch[i]));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Watch& watch : unfinished) {
+        watched.push_back(std::move(watch));
+    }
+}
+
+JobWatcher::Outcome JobWatcher::outcome(pplx::task<http_response>& request) {
+    try {
+        http_response response = request.get();
+        // Finished jobs are dropped from the service after a while; a job
+        // that is gone cannot be writing a report any more.
+        if (response.status_code() == status_codes::NotFound) {
+            return Outcome::Finished;
+        }
+        if (response.status_code() != status_codes::OK) {
+            return Outcome::Unknown;
+        }
+
+        json::value job = response.extract_json().get();
+        if (!job.has_field(U("status")) || !job[U("status")].is_string()) {
+            return Outcome::Unknown;
+        }
+        const utility::string_t& status = job[U("status")].as_string();
+        return status == U("completed") || status == U("failed") ? Outcome::Finished : Outcome::Pending;
+    } catch (const std::exception&) {
+        return Outcome::Unknown;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cpprest/http_client.h>
+
+// Follows analysis jobs queued through the gateway by polling the analysis
+// service's /jobs/{id} from a background thread. The listener is called once
+// per job when it has completed, failed or expired from the service.
+class JobWatcher {
+public:
+    using Listener = std::function<void(const std::string& cache_key)>;
+
+private:
+    struct Watch {
+        std::string job_id;
+        std::string cache_key;
+    };
+
+    enum class Outcome {
+        Pending,
+        Finished,
+        Unknown
+    };
+
+    web::http::client::http_client client;
+    std::chrono::milliseconds interval;
+    size_t batch_size;
+
+    mutable std::mutex mutex;
+    std::deque<Watch> watched;
+    Listener listener;
+
+    std::thread worker;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+
+    void run();
+    void poll();
+    static Outcome outcome(pplx::task<web::http::http_response>& request);
+
+public:
+    JobWatcher(const std::string& analysis_service_url,
+               std::chrono::milliseconds interval,
+               size_t batch_size);
+    ~JobWatcher();
+
+    // Called from the watcher thread; set before start().
+    void set_listener(Listener listener);
+
+    void watch(const std::string& job_id, const std::string& cache_key);
+
+    void start();
+    void stop();
+
+    size_t size() const;
+};
@@ -13,15 +13,19 @@ int main() {
         std::getenv("ANALYSIS_SERVICE_URL") : "http://localhost:8082";
     std::string gateway_port = std::getenv("GATEWAY_PORT") ? 
         std::getenv("GATEWAY_PORT") : "8080";
+    int probe_interval_ms = std::getenv("HEALTH_PROBE_INTERVAL_MS") ?
+        std::atoi(std::getenv("HEALTH_PROBE_INTERVAL_MS")) : 2000;
     
     std::cout << "File Service URL: " << file_service_url << std::endl;
     std::cout << "Analysis Service URL: " << analysis_service_url << std::endl;
     std::cout << "Gateway port: " << gateway_port << std::endl;
+    std::cout << "Health probe interval: " << probe_interval_ms << " ms" << std::endl;
     
     try {
         APIGateway gateway("http://0.0.0.0:" + gateway_port,
                           file_service_url,
-                          analysis_service_url);
+                          analysis_service_url,
+                          std::chrono::milliseconds(probe_interval_ms > 0 ? probe_interval_ms : 2000));
 
         gateway.start();
         
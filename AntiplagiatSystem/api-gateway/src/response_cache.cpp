@@ -0,0 +1,148 @@
+#include "response_cache.h"
+#include <algorithm>
+#include <cstdint>
+
+ResponseCache::ResponseCache(size_t max_entries, size_t max_bytes, size_t max_entry_bytes,
+                             std::chrono::seconds ttl)
+    : max_entries(max_entries == 0 ? 1 : max_entries),
+      max_bytes(max_bytes),
+      max_entry_bytes(max_entry_bytes),
+      ttl(ttl) {}
+
+void ResponseCache::erase(std::unordered_map<std::string, LruList::iterator>::iterator it) {
+    total_bytes -= it->second->second->body.size();
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+void ResponseCache::evict() {
+    while (!lru.empty() && (index.size() > max_entries || total_bytes > max_bytes)) {
+        erase(index.find(lru.back().first));
+    }
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return nullptr;
+    }
+
+    if (Clock::now() - it->second->second->stored_at > ttl) {
+        erase(it);
+        return nullptr;
+    }
+
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::put(const std::string& key,
+                                                               std::vector<unsigned char> body,
+                                                               const std::string& content_type,
+                                                               uint64_t generation) {
+    auto entry = std::make_shared<Entry>();
+    entry->etag = make_etag(body);
+    entry->body = std::move(body);
+    entry->content_type = content_type;
+    entry->stored_at = Clock::now();
+
+    if (entry->body.size() > max_entry_bytes) {
+        return entry;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto state = keys.find(key);
+    if ((state != keys.end() && state->second.holds > 0) || generation != generation_locked(key)) {
+        return entry;
+    }
+
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        erase(existing);
+    }
+
+    lru.emplace_front(key, entry);
+    index[key] = lru.begin();
+    total_bytes += entry->body.size();
+    evict();
+
+    return entry;
+}
+
+void ResponseCache::hold(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        erase(it);
+    }
+    if (keys.size() >= max_entries && keys.count(key) == 0) {
+        forget_released();
+    }
+    KeyState& state = keys[key];
+    state.holds++;
+    state.generation = ++last_generation;
+}
+
+void ResponseCache::release(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto state = keys.find(key);
+    if (state == keys.end()) {
+        return;
+    }
+    if (state->second.holds > 0) {
+        state->second.holds--;
+    }
+    state->second.generation = ++last_generation;
+}
+
+void ResponseCache::forget_released() {
+    // Raising the floor to the newest forgotten generation rejects any fetch
+    // that started before a forgotten release, whatever its key.
+    for (auto it = keys.begin(); it != keys.end();) {
+        if (it->second.holds == 0) {
+            forgotten_generation = std::max(forgotten_generation, it->second.generation);
+            it = keys.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+uint64_t ResponseCache::generation_locked(const std::string& key) const {
+    auto state = keys.find(key);
+    return state == keys.end() ? forgotten_generation : state->second.generation;
+}
+
+uint64_t ResponseCache::generation(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation_locked(key);
+}
+
+size_t ResponseCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+std::string ResponseCache::make_etag(const std::vector<unsigned char>& body) {
+    // FNV-1a over the body; the length is mixed in to keep distinct sizes apart.
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= body.size();
+    hash *= 1099511628211ULL;
+
+    static const char digits[] = "0123456789abcdef";
+    std::string etag = "\"";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        etag += digits[(hash >> shift) & 0xF];
+    }
+    etag += "\"";
+    return etag;
+}
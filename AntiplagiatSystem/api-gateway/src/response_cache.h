@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bounded LRU cache of upstream response bodies with a strong ETag per entry.
+// A key can be held while the data behind it is being rewritten: it is not
+// cached until every hold is released. Callers read generation(key) before
+// the upstream request and pass it to put(), so a response that raced a hold
+// or release of that key is not stored.
+class ResponseCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::vector<unsigned char> body;
+        std::string content_type;
+        std::string etag;
+        Clock::time_point stored_at;
+    };
+
+private:
+    using LruList = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;
+
+    size_t max_entries;
+    size_t max_bytes;
+    size_t max_entry_bytes;
+    std::chrono::seconds ttl;
+
+    mutable std::mutex mutex;
+    LruList lru;
+    std::unordered_map<std::string, LruList::iterator> index;
+    struct KeyState {
+        size_t holds = 0;
+        uint64_t generation = 0;
+    };
+
+    // Keys that were ever held, with the generation of their last hold or
+    // release. Released keys are forgotten once there are too many; keys not
+    // listed read as forgotten_generation, which covers everything forgotten.
+    std::unordered_map<std::string, KeyState> keys;
+    uint64_t last_generation = 0;
+    uint64_t forgotten_generation = 0;
+    size_t total_bytes = 0;
+
+    void erase(std::unordered_map<std::string, LruList::iterator>::iterator it);
+    void evict();
+    void forget_released();
+    uint64_t generation_locked(const std::string& key) const;
+
+public:
+    ResponseCache(size_t max_entries, size_t max_bytes, size_t max_entry_bytes,
+                  std::chrono::seconds ttl);
+
+    std::shared_ptr<const Entry> get(const std::string& key);
+    // Builds the entry (ETag included) and stores it unless the key is held,
+    // the key was held or released since generation was read, or the body is
+    // too large. The entry is returned either way.
+    std::shared_ptr<const Entry> put(const std::string& key,
+                                     std::vector<unsigned char> body,
+                                     const std::string& content_type,
+                                     uint64_t generation);
+    // Drops the key and keeps it out of the cache until the matching release().
+    void hold(const std::string& key);
+    void release(const std::string& key);
+
+    uint64_t generation(const std::string& key) const;
+    size_t size() const;
+
+    static std::string make_etag(const std::vector<unsigned char>& body);
+};
@@ -0,0 +1,116 @@
+#include "router.h"
+#include <algorithm>
+#include <stdexcept>
+
+bool Router::Route::allows(const std::string& method) const {
+    return std::find(methods.begin(), methods.end(), method) != methods.end();
+}
+
+Router::Router(std::vector<Route> routes)
+    : routes(std::move(routes)) {
+    nodes.emplace_back();
+
+    for (size_t i = 0; i < this->routes.size(); i++) {
+        const Route& route = this->routes[i];
+
+        int node = 0;
+        for (char c : route.pattern) {
+            int next = child(node, c);
+            node = next >= 0 ? next : add_child(node, c);
+        }
+
+        int& slot = route.kind == MatchKind::Exact ? nodes[node].exact_route : nodes[node].prefix_route;
+        if (slot >= 0) {
+            throw std::invalid_argument("Duplicate route: " + route.pattern);
+        }
+        slot = static_cast<int>(i);
+    }
+}
+
+int Router::child(int node, char c) const {
+    for (const auto& entry : nodes[node].children) {
+        if (entry.first == c) {
+            return entry.second;
+        }
+    }
+    return -1;
+}
+
+int Router::add_child(int node, char c) {
+    int next = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[node].children.emplace_back(c, next);
+    return next;
+}
+
+bool Router::match(const std::string& path, Match& match) const {
+    int node = 0;
+    int best_prefix = -1;
+    size_t best_length = 0;
+
+    for (size_t i = 0; i <= path.size(); i++) {
+        const Node& current = nodes[node];
+
+        // A prefix route only applies on a segment boundary, so "/api/works"
+        // matches "/api/works/7" but not "/api/worksheet". "/api/reports/"
+        // stands for "/api/reports/{id}" and does not match an empty id.
+        if (current.prefix_route >= 0) {
+            bool boundary = i == path.size() || path[i] == '/' || (i > 0 && path[i - 1] == '/');
+            bool needs_rest = routes[current.prefix_route].pattern.back() == '/';
+            if (boundary && !(needs_rest && i == path.size())) {
+                best_prefix = current.prefix_route;
+                best_length = i;
+            }
+        }
+
+        if (i == path.size()) {
+            if (current.exact_route >= 0) {
+                const Route& route = routes[current.exact_route];
+                match.route = &route;
+                match.target_path = route.rewrite;
+                return true;
+            }
+            break;
+        }
+
+        node = child(node, path[i]);
+        if (node < 0) {
+            break;
+        }
+    }
+
+    if (best_prefix < 0) {
+        return false;
+    }
+
+    const Route& route = routes[best_prefix];
+    match.route = &route;
+    match.target_path.reserve(route.rewrite.size() + path.size() - best_length);
+    match.target_path.assign(route.rewrite);
+    match.target_path.append(path, best_length, std::string::npos);
+    return true;
+}
+
+const char* Router::upstream_name(Upstream upstream) {
+    return upstream == Upstream::FileService ? "File service" : "Analysis service";
+}
+
+std::vector<Router::Route> default_routes() {
+    using Kind = Router::MatchKind;
+    using Up = Router::Upstream;
+    using Cache = Router::CachePolicy;
+
+    return {
+        {"/api/files/", Kind::Prefix, Up::FileService, "/files/", {"GET"}},
+        {"/api/upload", Kind::Exact, Up::FileService, "/upload", {"POST"}, Cache::None, false},
+        {"/api/upload/stream", Kind::Exact, Up::FileService, "/upload/stream", {"POST"}, Cache::None, false},
+        {"/api/upload/bulk", Kind::Exact, Up::FileService, "/upload/bulk", {"POST"}, Cache::None, false},
+        {"/api/works", Kind::Prefix, Up::FileService, "/works", {"GET"}},
+        {"/api/reports", Kind::Exact, Up::FileService, "/reports", {"GET"}},
+
+        {"/api/reports/", Kind::Prefix, Up::AnalysisService, "/reports/", {"GET"}, Cache::Store},
+        {"/api/analyze", Kind::Exact, Up::AnalysisService, "/analyze", {"POST"}, Cache::Invalidate},
+        {"/api/analyze/assignment/", Kind::Prefix, Up::AnalysisService, "/analyze/assignment/", {"POST"}},
+        {"/api/jobs/", Kind::Prefix, Up::AnalysisService, "/jobs/", {"GET"}}
+    };
+}
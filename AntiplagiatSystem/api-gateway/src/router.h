@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Route table compiled into a character trie at startup. A lookup walks the
+// path once, so its cost depends on the path length only, not on the number
+// of routes.
+class Router {
+public:
+    enum class Upstream {
+        FileService,
+        AnalysisService
+    };
+
+    enum class MatchKind {
+        Exact,  // path must equal the pattern
+        Prefix  // pattern plus anything after it on a '/' boundary; a pattern
+                // ending in '/' needs a non-empty remainder
+    };
+
+    enum class CachePolicy {
+        None,
+        Store,      // GET responses may be served from the gateway cache
+        Invalidate  // a queued analysis holds its work's cached report
+    };
+
+    struct Route {
+        std::string pattern;
+        MatchKind kind;
+        Upstream upstream;
+        std::string rewrite;  // replaces the matched pattern in the upstream path
+        std::vector<std::string> methods;
+        CachePolicy cache = CachePolicy::None;
+        // Off for uploads: their latency follows the body size, not the
+        // upstream's load, and would read as spikes to the concurrency limit.
+        bool sample_latency = true;
+
+        bool allows(const std::string& method) const;
+    };
+
+    struct Match {
+        const Route* route = nullptr;
+        std::string target_path;
+    };
+
+private:
+    struct Node {
+        std::vector<std::pair<char, int>> children;
+        int exact_route = -1;
+        int prefix_route = -1;
+    };
+
+    std::vector<Route> routes;
+    std::vector<Node> nodes;
+
+    int child(int node, char c) const;
+    int add_child(int node, char c);
+
+public:
+    explicit Router(std::vector<Route> routes);
+
+    bool match(const std::string& path, Match& match) const;
+    static const char* upstream_name(Upstream upstream);
+    const std::vector<Route>& table() const { return routes; }
+};
+
+std::vector<Router::Route> default_routes();
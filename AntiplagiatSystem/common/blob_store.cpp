@@ -0,0 +1,112 @@
+#include "blob_store.h"
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+BlobStore::BlobStore(const std::string& root)
+    : root(root) {}
+
+bool BlobStore::is_valid_hash(const std::string& file_hash) {
+    if (file_hash.size() != 64) {
+        return false;
+    }
+    for (char c : file_hash) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BlobStore::path_for(const std::string& file_hash) const {
+    if (!is_valid_hash(file_hash)) {
+        throw std::invalid_argument("Invalid blob hash: " + file_hash);
+    }
+    return (fs::path(root) / file_hash.substr(0, 2) / file_hash.substr(2, 2) / file_hash).string();
+}
+
+bool BlobStore::exists(const std::string& file_hash) const {
+    std::error_code error;
+    return is_valid_hash(file_hash) && fs::exists(path_for(file_hash), error);
+}
+
+std::string BlobStore::make_temp_path() {
+    fs::path temp_dir = fs::path(root) / "tmp";
+    fs::create_directories(temp_dir);
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    return (temp_dir /
+            (std::to_string(::getpid()) + "_" + std::to_string(now) + "_" +
+             std::to_string(temp_counter++))).string();
+}
+
+std::string BlobStore::commit(const std::string& temp_path, const std::string& file_hash) {
+    fs::path target = path_for(file_hash);
+
+    std::error_code error;
+    if (fs::exists(target, error)) {
+        fs::remove(temp_path, error);
+        return target.string();
+    }
+
+    fs::create_directories(target.parent_path());
+    fs::rename(temp_path, target);
+    return target.string();
+}
+
+BlobStore::Pin BlobStore::pin(const std::string& file_hash) {
+    return Pin(*this, file_hash);
+}
+
+BlobStore::Pin::Pin(BlobStore& store, const std::string& file_hash)
+    : store(&store), file_hash(file_hash) {
+    std::lock_guard<std::mutex> lock(store.pins_mutex);
+    store.pins[file_hash]++;
+}
+
+BlobStore::Pin::Pin(Pin&& other) noexcept
+    : store(other.store), file_hash(std::move(other.file_hash)) {
+    other.store = nullptr;
+}
+
+BlobStore::Pin::~Pin() {
+    if (!store) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(store->pins_mutex);
+    auto it = store->pins.find(file_hash);
+    if (it != store->pins.end() && --it->second == 0) {
+        store->pins.erase(it);
+    }
+}
+
+bool BlobStore::Pin::release_and_remove(const std::function<bool()>& is_referenced) {
+    if (!store) {
+        return false;
+    }
+    BlobStore& owner = *store;
+    store = nullptr;
+
+    std::lock_guard<std::mutex> lock(owner.pins_mutex);
+    auto it = owner.pins.find(file_hash);
+    if (it != owner.pins.end() && --it->second == 0) {
+        owner.pins.erase(it);
+    } else {
+        return false;
+    }
+
+    try {
+        if (is_referenced()) {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    std::error_code error;
+    return is_valid_hash(file_hash) && fs::remove(owner.path_for(file_hash), error);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Content-addressed storage for uploaded works: every blob lives at
+// <root>/<hash[0:2]>/<hash[2:4]>/<hash>, so identical uploads share one file
+// and any service can locate a work from its SHA-256 alone. A blob is
+// referenced by the works rows carrying the same file_hash.
+class BlobStore {
+private:
+    std::string root;
+    std::atomic<unsigned long long> temp_counter{0};
+
+    // Uploads in flight per hash. Guarded together with removal, so a blob is
+    // never deleted between another upload's exists()/commit() and its insert.
+    std::mutex pins_mutex;
+    std::unordered_map<std::string, size_t> pins;
+
+public:
+    // Held by an upload from before it checks for the blob until its works
+    // row is stored or has failed.
+    class Pin {
+    private:
+        BlobStore* store;
+        std::string file_hash;
+
+    public:
+        Pin(BlobStore& store, const std::string& file_hash);
+        Pin(Pin&& other) noexcept;
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        Pin& operator=(Pin&&) = delete;
+        ~Pin();
+
+        // Releases the pin after a failed insert. The blob is deleted only if
+        // no other upload holds a pin on it and is_referenced() says no works
+        // row points at it; an error from is_referenced() keeps the blob.
+        bool release_and_remove(const std::function<bool()>& is_referenced);
+    };
+
+    explicit BlobStore(const std::string& root);
+
+    static bool is_valid_hash(const std::string& file_hash);
+
+    std::string path_for(const std::string& file_hash) const;
+    bool exists(const std::string& file_hash) const;
+
+    std::string make_temp_path();
+    // Moves a fully written temp file into place. If the blob already exists
+    // the temp file is discarded. Returns the blob path.
+    std::string commit(const std::string& temp_path, const std::string& file_hash);
+    Pin pin(const std::string& file_hash);
+};
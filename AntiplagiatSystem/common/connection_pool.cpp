@@ -0,0 +1,140 @@
+#include "connection_pool.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+const auto VALIDATE_AFTER_IDLE = std::chrono::seconds(30);
+}
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, std::unique_ptr<pqxx::connection> conn)
+    : pool(pool), conn(std::move(conn)) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), conn(std::move(other.conn)) {
+    other.pool = nullptr;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (pool) {
+        pool->release(std::move(conn));
+    }
+}
+
+pqxx::connection& ConnectionPool::Lease::operator*() const {
+    return *conn;
+}
+
+pqxx::connection* ConnectionPool::Lease::operator->() const {
+    return conn.get();
+}
+
+ConnectionPool::ConnectionPool(const std::string& connection_string,
+                               size_t max_size,
+                               Preparer preparer,
+                               std::chrono::milliseconds acquire_timeout)
+    : connection_string(connection_string),
+      max_size(max_size == 0 ? 1 : max_size),
+      preparer(std::move(preparer)),
+      acquire_timeout(acquire_timeout) {
+    auto first = connect();
+    std::lock_guard<std::mutex> lock(mutex);
+    open_count = 1;
+    idle.push_back({std::move(first), std::chrono::steady_clock::now()});
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.clear();
+}
+
+std::unique_ptr<pqxx::connection> ConnectionPool::connect() {
+    auto conn = std::make_unique<pqxx::connection>(connection_string);
+    if (!conn->is_open()) {
+        throw std::runtime_error("Cannot open database connection");
+    }
+    if (preparer) {
+        preparer(*conn);
+    }
+    return conn;
+}
+
+bool ConnectionPool::validate(pqxx::connection& conn,
+                              std::chrono::steady_clock::time_point last_used) {
+    if (!conn.is_open()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() - last_used < VALIDATE_AFTER_IDLE) {
+        return true;
+    }
+
+    try {
+        pqxx::nontransaction ping(conn);
+        ping.exec("SELECT 1");
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[DB POOL] Dropping stale connection: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        bool ready = available.wait_for(lock, acquire_timeout, [this] {
+            return !idle.empty() || open_count < max_size;
+        });
+        if (!ready) {
+            throw std::runtime_error("Timed out waiting for a database connection");
+        }
+
+        if (!idle.empty()) {
+            IdleConnection entry = std::move(idle.back());
+            idle.pop_back();
+
+            lock.unlock();
+            if (validate(*entry.conn, entry.last_used)) {
+                return Lease(this, std::move(entry.conn));
+            }
+            entry.conn.reset();
+            lock.lock();
+            open_count--;
+            continue;
+        }
+
+        open_count++;
+        lock.unlock();
+        try {
+            return Lease(this, connect());
+        } catch (...) {
+            lock.lock();
+            open_count--;
+            available.notify_one();
+            throw;
+        }
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> conn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (conn && conn->is_open()) {
+        idle.push_back({std::move(conn), std::chrono::steady_clock::now()});
+    } else {
+        open_count--;
+    }
+    available.notify_one();
+}
+
+bool ConnectionPool::healthy() {
+    try {
+        auto lease = acquire();
+        return lease->is_open();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+size_t ConnectionPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return open_count;
+}
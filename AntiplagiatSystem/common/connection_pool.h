@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+// Bounded pool of pqxx connections. Connections are opened lazily up to
+// max_size, every new connection gets the fixed prepared statements via the
+// preparer callback, idle connections are pinged before reuse, and closed
+// connections are dropped and replaced instead of being handed out again.
+class ConnectionPool {
+public:
+    using Preparer = std::function<void(pqxx::connection&)>;
+
+    class Lease {
+    private:
+        ConnectionPool* pool;
+        std::unique_ptr<pqxx::connection> conn;
+
+    public:
+        Lease(ConnectionPool* pool, std::unique_ptr<pqxx::connection> conn);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const;
+        pqxx::connection* operator->() const;
+    };
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<pqxx::connection> conn;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    std::string connection_string;
+    size_t max_size;
+    Preparer preparer;
+    std::chrono::milliseconds acquire_timeout;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<IdleConnection> idle;
+    size_t open_count = 0;
+
+    std::unique_ptr<pqxx::connection> connect();
+    bool validate(pqxx::connection& conn, std::chrono::steady_clock::time_point last_used);
+    void release(std::unique_ptr<pqxx::connection> conn);
+
+public:
+    ConnectionPool(const std::string& connection_string,
+                   size_t max_size,
+                   Preparer preparer,
+                   std::chrono::milliseconds acquire_timeout = std::chrono::seconds(10));
+    ~ConnectionPool();
+
+    Lease acquire();
+    bool healthy();
+    size_t size() const;
+
+    // Runs fn with a leased connection; on a broken connection the call is
+    // retried once on a freshly opened one.
+    template <typename Fn>
+    auto run(Fn&& fn) -> decltype(fn(std::declval<pqxx::connection&>())) {
+        try {
+            auto lease = acquire();
+            return fn(*lease);
+        } catch (const pqxx::broken_connection&) {
+            auto lease = acquire();
+            return fn(*lease);
+        }
+    }
+};
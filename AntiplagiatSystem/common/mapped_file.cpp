@@ -0,0 +1,67 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filepath)
+    : bytes(nullptr), length(0) {
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + filepath + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file: " + filepath + " (" + std::strerror(error) + ")");
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return;
+    }
+
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        length = 0;
+        throw std::runtime_error("Cannot map file: " + filepath + " (" + std::strerror(error) + ")");
+    }
+
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+    bytes = static_cast<const char*>(mapping);
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+}
+
+const char* MappedFile::data() const {
+    return bytes;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::empty() const {
+    return length == 0;
+}
+
+std::string_view MappedFile::view() const {
+    return bytes == nullptr ? std::string_view() : std::string_view(bytes, length);
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& filepath) {
+    return std::make_shared<MappedFile>(filepath);
+}
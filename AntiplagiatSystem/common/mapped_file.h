@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Read-only mmap view of a whole file. Shared between the analysis pipeline
+// (normalizer, fingerprinting) and the file service (hashing, downloads) so
+// file contents are never copied into heap buffers.
+class MappedFile {
+private:
+    const char* bytes;
+    size_t length;
+
+public:
+    explicit MappedFile(const std::string& filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const;
+    size_t size() const;
+    bool empty() const;
+    std::string_view view() const;
+
+    static std::shared_ptr<MappedFile> open(const std::string& filepath);
+};
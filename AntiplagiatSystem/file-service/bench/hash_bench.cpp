@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include "sha256.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// The hashing FileHandler did originally: a fresh EVP context per file,
+// 4 KB reads and stringstream hex encoding.
+std::string legacy_hash_file(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr);
+
+    char buffer[4096];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        EVP_DigestUpdate(mdctx, buffer, file.gcount());
+    }
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+    EVP_DigestFinal_ex(mdctx, hash, &hash_len);
+    EVP_MD_CTX_free(mdctx);
+
+    std::stringstream ss;
+    for (unsigned int i = 0; i < hash_len; i++) {
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    }
+    return ss.str();
+}
+
+double measure(const std::string& name, size_t total_bytes, const std::function<void()>& run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double gbps = total_bytes / seconds / 1e9;
+    std::cout << std::left << std::setw(28) << name << std::fixed << std::setprecision(2)
+              << gbps << " GB/s" << std::endl;
+    return gbps;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t file_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    size_t file_size = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4) * 1024 * 1024;
+
+    fs::path dir = fs::temp_directory_path() / ("hash_bench_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+
+    std::mt19937_64 rng(42);
+    std::vector<std::string> contents(file_count);
+    std::vector<std::string> paths(file_count);
+    for (size_t i = 0; i < file_count; i++) {
+        contents[i].resize(file_size);
+        for (size_t j = 0; j + 8 <= file_size; j += 8) {
+            uint64_t value = rng();
+            contents[i].replace(j, 8, reinterpret_cast<const char*>(&value), 8);
+        }
+        paths[i] = (dir / std::to_string(i)).string();
+        std::ofstream(paths[i], std::ios::binary).write(contents[i].data(), contents[i].size());
+    }
+
+    std::vector<std::string_view> views(contents.begin(), contents.end());
+    size_t total = file_count * file_size;
+
+    std::vector<std::string> expected(file_count);
+    for (size_t i = 0; i < file_count; i++) {
+        expected[i] = legacy_hash_file(paths[i]);
+    }
+    if (Sha256::hash_files(paths) != expected || Sha256::hash_buffers(views) != expected) {
+        std::cerr << "Hash mismatch" << std::endl;
+        fs::remove_all(dir);
+        return 1;
+    }
+
+    std::cout << "Files: " << file_count << " x " << file_size / (1024 * 1024) << " MB, "
+              << "threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    measure("legacy (4 KB reads)", total, [&] {
+        for (const auto& path : paths) {
+            legacy_hash_file(path);
+        }
+    });
+    measure("hash_file (mmap)", total, [&] {
+        for (const auto& path : paths) {
+            Sha256::hash_file(path);
+        }
+    });
+    measure("hash_files (parallel)", total, [&] {
+        Sha256::hash_files(paths);
+    });
+    measure("hash_buffers (parallel)", total, [&] {
+        Sha256::hash_buffers(views);
+    });
+
+    size_t small_count = 200000;
+    std::string small(512, 'x');
+    measure("digest 512 B x 200k", small_count * small.size(), [&] {
+        for (size_t i = 0; i < small_count; i++) {
+            Sha256::digest(small.data(), small.size());
+        }
+    });
+    measure("ctx per call 512 B x 200k", small_count * small.size(), [&] {
+        for (size_t i = 0; i < small_count; i++) {
+            Sha256 hasher;
+            hasher.update(small.data(), small.size());
+            hasher.finish();
+        }
+    });
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -1,16 +1,21 @@
 #include "database.h"
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
-Database::Database(const std::string& connection_string) {
+Database::Database(const std::string& connection_string, size_t pool_size) {
     try {
-        conn = std::make_unique<pqxx::connection>(connection_string);
-        if (conn->is_open()) {
-            std::cout << "[DATABASE] Connected to PostgreSQL successfully" << std::endl;
-            create_tables();
-        } else {
-            throw std::runtime_error("Cannot open database connection");
+        {
+            pqxx::connection bootstrap(connection_string);
+            if (!bootstrap.is_open()) {
+                throw std::runtime_error("Cannot open database connection");
+            }
+            create_tables(bootstrap);
         }
+
+        pool = std::make_unique<ConnectionPool>(connection_string, pool_size, &Database::prepare_statements);
+        std::cout << "[DATABASE] Connected to PostgreSQL successfully (pool size " << pool_size << ")" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] " << e.what() << std::endl;
         throw;
@@ -18,19 +23,65 @@ Database::Database(const std::string& connection_string) {
 }
 
 Database::~Database() {
-    if (conn && conn->is_open()) {
-        conn->close();
-        std::cout << "[DATABASE] Connection closed" << std::endl;
-    }
+    pool.reset();
+    std::cout << "[DATABASE] Connections closed" << std::endl;
 }
 
 bool Database::is_connected() const {
-    return conn && conn->is_open();
+    return pool && pool->healthy();
 }
 
-void Database::create_tables() {
+void Database::prepare_statements(pqxx::connection& conn) {
+    conn.prepare("find_work_by_hash", "SELECT id, student_id FROM works WHERE file_hash = $1");
+    conn.prepare("mark_duplicate", "UPDATE works SET status = 'duplicate_detected' WHERE id = $1");
+    conn.prepare("insert_work",
+                 "INSERT INTO works (student_id, student_name, assignment_id, assignment_name, "
+                 "file_path, original_filename, file_hash, status) "
+                 "VALUES ($1, $2, $3, $4, $5, $6, $7, 'uploaded') RETURNING id");
+    conn.prepare("get_file_path", "SELECT file_path FROM works WHERE id = $1");
+    conn.prepare("get_file_info",
+                 "SELECT file_path, file_hash, original_filename FROM works WHERE id = $1");
+    conn.prepare("count_works_by_hash", "SELECT COUNT(*) as count FROM works WHERE file_hash = $1");
+    conn.prepare("update_work_status", "UPDATE works SET status = $1 WHERE id = $2");
+    conn.prepare("delete_report", "DELETE FROM reports WHERE work_id = $1");
+    conn.prepare("insert_report",
+                 "INSERT INTO reports (work_id, plagiarism_found, similarity_percentage, "
+                 "matched_work_id, matched_student_name, report_data) "
+                 "VALUES ($1, $2, $3, $4, $5, $6)");
+    conn.prepare("get_report_json", "SELECT report_data::text as report FROM reports WHERE work_id = $1");
+    conn.prepare("count_reports", "SELECT COUNT(*) as count FROM reports WHERE work_id = $1");
+
+    // Keyset pages: rows come newest first ordered by (time, id), and the
+    // next page starts strictly below the last (time, id) pair returned.
+    // Cursor times travel as CURSOR_TIME_FORMAT text so they round-trip
+    // to the microsecond.
+    const std::string works_columns =
+        "SELECT id, student_id, student_name, original_filename, upload_time, status, "
+        "to_char(upload_time, '" + std::string(CURSOR_TIME_FORMAT) + "') AS cursor_time "
+        "FROM works WHERE assignment_id = $1 ";
+    conn.prepare("get_works_first_page",
+                 works_columns + "ORDER BY upload_time DESC, id DESC LIMIT $2");
+    conn.prepare("get_works_next_page",
+                 works_columns +
+                 "AND (upload_time, id) < (to_timestamp($2, '" + std::string(CURSOR_TIME_FORMAT) +
+                 "')::timestamp, $3) ORDER BY upload_time DESC, id DESC LIMIT $4");
+
+    const std::string reports_columns =
+        "SELECT r.id, r.work_id, w.student_name, w.assignment_name, "
+        "r.plagiarism_found, r.similarity_percentage, r.matched_student_name, r.analysis_time, "
+        "to_char(r.analysis_time, '" + std::string(CURSOR_TIME_FORMAT) + "') AS cursor_time "
+        "FROM reports r JOIN works w ON r.work_id = w.id ";
+    conn.prepare("get_reports_first_page",
+                 reports_columns + "ORDER BY r.analysis_time DESC, r.id DESC LIMIT $1");
+    conn.prepare("get_reports_next_page",
+                 reports_columns +
+                 "WHERE (r.analysis_time, r.id) < (to_timestamp($1, '" + std::string(CURSOR_TIME_FORMAT) +
+                 "')::timestamp, $2) ORDER BY r.analysis_time DESC, r.id DESC LIMIT $3");
+}
+
+void Database::create_tables(pqxx::connection& conn) {
     try {
-        pqxx::work txn(*conn);
+        pqxx::work txn(conn);
         
         txn.exec("CREATE TABLE IF NOT EXISTS works ("
                  "id SERIAL PRIMARY KEY,"
@@ -54,6 +105,11 @@ void Database::create_tables() {
                  "matched_student_name VARCHAR(255),"
                  "report_data JSONB,"
                  "status VARCHAR(50) DEFAULT 'completed')");
+
+        txn.exec("CREATE INDEX IF NOT EXISTS idx_works_assignment_upload "
+                 "ON works(assignment_id, upload_time DESC, id DESC)");
+        txn.exec("CREATE INDEX IF NOT EXISTS idx_reports_analysis_time "
+                 "ON reports(analysis_time DESC, id DESC)");
         
         txn.commit();
         std::cout << "[DATABASE] Tables created/verified" << std::endl;
@@ -71,41 +127,35 @@ int Database::save_work(const std::string& student_id,
                        const std::string& original_filename,
                        const std::string& file_hash) {
     try {
-        pqxx::work txn(*conn);
+        return pool->run([&](pqxx::connection& conn) -> int {
+            pqxx::work txn(conn);
 
-        pqxx::result existing = txn.exec_params(
-            "SELECT id, student_id FROM works WHERE file_hash = $1",
-            file_hash
-        );
-        
-        if (!existing.empty()) {
-            int existing_id = existing[0]["id"].as<int>();
-            std::string existing_student = existing[0]["student_id"].as<std::string>();
+            pqxx::result existing = txn.exec_prepared("find_work_by_hash", file_hash);
             
-            if (existing_student != student_id) {
-                txn.exec_params(
-                    "UPDATE works SET status = 'duplicate_detected' WHERE id = $1",
-                    existing_id
-                );
+            if (!existing.empty()) {
+                int existing_id = existing[0]["id"].as<int>();
+                std::string existing_student = existing[0]["student_id"].as<std::string>();
+                
+                if (existing_student != student_id) {
+                    txn.exec_prepared("mark_duplicate", existing_id);
+                }
+                
+                txn.commit();
+                return existing_id; 
             }
+
+            pqxx::result result = txn.exec_prepared(
+                "insert_work",
+                student_id, student_name, assignment_id, assignment_name,
+                file_path, original_filename, file_hash
+            );
             
+            int work_id = result[0]["id"].as<int>();
             txn.commit();
-            return existing_id; 
-        }
-
-        pqxx::result result = txn.exec_params(
-            "INSERT INTO works (student_id, student_name, assignment_id, assignment_name, "
-            "file_path, original_filename, file_hash, status) "
-            "VALUES ($1, $2, $3, $4, $5, $6, $7, 'uploaded') RETURNING id",
-            student_id, student_name, assignment_id, assignment_name,
-            file_path, original_filename, file_hash
-        );
-        
-        int work_id = result[0]["id"].as<int>();
-        txn.commit();
-        
-        std::cout << "[DATABASE] Work saved with ID: " << work_id << std::endl;
-        return work_id;
+            
+            std::cout << "[DATABASE] Work saved with ID: " << work_id << std::endl;
+            return work_id;
+        });
         
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] save_work: " << e.what() << std::endl;
@@ -113,34 +163,188 @@ int Database::save_work(const std::string& student_id,
     }
 }
 
+std::vector<int> Database::save_works(const std::vector<NewWork>& works) {
+    if (works.empty()) {
+        return {};
+    }
+
+    try {
+        return pool->run([&](pqxx::connection& conn) -> std::vector<int> {
+            pqxx::work txn(conn);
+
+            struct KnownWork {
+                int id;
+                std::string student_id;
+            };
+            std::unordered_map<std::string, KnownWork> known;
+
+            auto hash_list = [&txn](const std::vector<const std::string*>& hashes) {
+                std::string list;
+                for (const auto* hash : hashes) {
+                    if (!list.empty()) {
+                        list += ',';
+                    }
+                    list += txn.quote(*hash);
+                }
+                return list;
+            };
+
+            std::vector<const std::string*> hashes;
+            std::unordered_set<std::string> seen;
+            for (const auto& work : works) {
+                if (seen.insert(work.file_hash).second) {
+                    hashes.push_back(&work.file_hash);
+                }
+            }
+
+            pqxx::result existing = txn.exec(
+                "SELECT id, student_id, file_hash FROM works WHERE file_hash IN (" + hash_list(hashes) + ")");
+            for (const auto& row : existing) {
+                known[row["file_hash"].as<std::string>()] =
+                    {row["id"].as<int>(), row["student_id"].as<std::string>()};
+            }
+
+            // Works whose hash is new to the table; the first upload of a hash
+            // within the batch owns the row, later ones resolve to it.
+            std::vector<size_t> to_insert;
+            std::unordered_set<std::string> pending;
+            for (size_t i = 0; i < works.size(); i++) {
+                const auto& hash = works[i].file_hash;
+                if (known.count(hash) == 0 && pending.insert(hash).second) {
+                    to_insert.push_back(i);
+                }
+            }
+
+            if (!to_insert.empty()) {
+                std::string insert =
+                    "INSERT INTO works (student_id, student_name, assignment_id, assignment_name, "
+                    "file_path, original_filename, file_hash, status) VALUES ";
+                for (size_t n = 0; n < to_insert.size(); n++) {
+                    const auto& work = works[to_insert[n]];
+                    if (n > 0) {
+                        insert += ',';
+                    }
+                    insert += "(" + txn.quote(work.student_id) + "," + txn.quote(work.student_name) + "," +
+                              txn.quote(work.assignment_id) + "," + txn.quote(work.assignment_name) + "," +
+                              txn.quote(work.file_path) + "," + txn.quote(work.original_filename) + "," +
+                              txn.quote(work.file_hash) + ",'uploaded')";
+                }
+                // A concurrent single upload may have inserted the same hash
+                // meanwhile; such rows are picked up by the re-select below.
+                insert += " ON CONFLICT (file_hash) DO NOTHING RETURNING id, student_id, file_hash";
+
+                pqxx::result inserted = txn.exec(insert);
+                for (const auto& row : inserted) {
+                    known[row["file_hash"].as<std::string>()] =
+                        {row["id"].as<int>(), row["student_id"].as<std::string>()};
+                }
+
+                if (inserted.size() < to_insert.size()) {
+                    std::vector<const std::string*> missing;
+                    for (size_t index : to_insert) {
+                        if (known.count(works[index].file_hash) == 0) {
+                            missing.push_back(&works[index].file_hash);
+                        }
+                    }
+                    pqxx::result raced = txn.exec(
+                        "SELECT id, student_id, file_hash FROM works WHERE file_hash IN (" +
+                        hash_list(missing) + ")");
+                    for (const auto& row : raced) {
+                        known[row["file_hash"].as<std::string>()] =
+                            {row["id"].as<int>(), row["student_id"].as<std::string>()};
+                    }
+                }
+            }
+
+            std::vector<int> ids;
+            std::unordered_set<int> duplicates;
+            ids.reserve(works.size());
+
+            for (size_t i = 0; i < works.size(); i++) {
+                const auto& work = works[i];
+                auto found = known.find(work.file_hash);
+                if (found == known.end()) {
+                    throw std::runtime_error("Work row missing after insert for hash " + work.file_hash);
+                }
+
+                // Same rule as save_work: another student's upload of an
+                // existing hash flags the row that already holds it.
+                ids.push_back(found->second.id);
+                if (found->second.student_id != work.student_id) {
+                    duplicates.insert(found->second.id);
+                }
+            }
+
+            if (!duplicates.empty()) {
+                std::string id_list;
+                for (int id : duplicates) {
+                    if (!id_list.empty()) {
+                        id_list += ',';
+                    }
+                    id_list += std::to_string(id);
+                }
+                txn.exec("UPDATE works SET status = 'duplicate_detected' WHERE id IN (" + id_list + ")");
+            }
+
+            txn.commit();
+            std::cout << "[DATABASE] Bulk saved " << works.size() << " works ("
+                      << to_insert.size() << " new rows)" << std::endl;
+            return ids;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "[DATABASE ERROR] save_works: " << e.what() << std::endl;
+        throw;
+    }
+}
+
 std::string Database::get_file_path(int work_id) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT file_path FROM works WHERE id = $1",
-            work_id
-        );
-        
-        if (result.empty()) {
-            throw std::runtime_error("Work not found with ID: " + std::to_string(work_id));
-        }
-        
-        return result[0]["file_path"].as<std::string>();
+        return pool->run([&](pqxx::connection& conn) -> std::string {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("get_file_path", work_id);
+            
+            if (result.empty()) {
+                throw std::runtime_error("Work not found with ID: " + std::to_string(work_id));
+            }
+            
+            return result[0]["file_path"].as<std::string>();
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] get_file_path: " << e.what() << std::endl;
         throw;
     }
 }
 
+Database::FileInfo Database::get_file_info(int work_id) {
+    try {
+        return pool->run([&](pqxx::connection& conn) -> FileInfo {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("get_file_info", work_id);
+            
+            if (result.empty()) {
+                throw std::runtime_error("Work not found with ID: " + std::to_string(work_id));
+            }
+            
+            FileInfo info;
+            info.file_path = result[0]["file_path"].as<std::string>();
+            info.file_hash = result[0]["file_hash"].as<std::string>();
+            info.original_filename = result[0]["original_filename"].as<std::string>();
+            return info;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "[DATABASE ERROR] get_file_info: " << e.what() << std::endl;
+        throw;
+    }
+}
+
 bool Database::hash_exists(const std::string& file_hash) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT COUNT(*) as count FROM works WHERE file_hash = $1",
-            file_hash
-        );
-        
-        return result[0]["count"].as<int>() > 0;
+        return pool->run([&](pqxx::connection& conn) -> bool {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("count_works_by_hash", file_hash);
+            
+            return result[0]["count"].as<int>() > 0;
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] hash_exists: " << e.what() << std::endl;
         throw;
@@ -149,17 +353,16 @@ bool Database::hash_exists(const std::string& file_hash) {
 
 int Database::get_work_id_by_hash(const std::string& file_hash) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT id FROM works WHERE file_hash = $1",
-            file_hash
-        );
-        
-        if (result.empty()) {
-            return -1;
-        }
-        
-        return result[0]["id"].as<int>();
+        return pool->run([&](pqxx::connection& conn) -> int {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("find_work_by_hash", file_hash);
+            
+            if (result.empty()) {
+                return -1;
+            }
+            
+            return result[0]["id"].as<int>();
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] get_work_id_by_hash: " << e.what() << std::endl;
         return -1;
@@ -168,12 +371,11 @@ int Database::get_work_id_by_hash(const std::string& file_hash) {
 
 void Database::update_work_status(int work_id, const std::string& status) {
     try {
-        pqxx::work txn(*conn);
-        txn.exec_params(
-            "UPDATE works SET status = $1 WHERE id = $2",
-            status, work_id
-        );
-        txn.commit();
+        pool->run([&](pqxx::connection& conn) {
+            pqxx::work txn(conn);
+            txn.exec_prepared("update_work_status", status, work_id);
+            txn.commit();
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] update_work_status: " << e.what() << std::endl;
         throw;
@@ -187,29 +389,26 @@ void Database::save_report(int work_id,
                           const std::string& matched_student_name,
                           const std::string& report_data) {
     try {
-        pqxx::work txn(*conn);
-
-        txn.exec_params("DELETE FROM reports WHERE work_id = $1", work_id);
-
-        txn.exec_params(
-            "INSERT INTO reports (work_id, plagiarism_found, similarity_percentage, "
-            "matched_work_id, matched_student_name, report_data) "
-            "VALUES ($1, $2, $3, $4, $5, $6)",
-            work_id,
-            plagiarism_found,
-            similarity_percentage,
-            matched_work_id,
-            matched_student_name,
-            report_data
-        );
-
-        std::string status = plagiarism_found ? "plagiarism_found" : "checked_ok";
-        txn.exec_params(
-            "UPDATE works SET status = $1 WHERE id = $2",
-            status, work_id
-        );
-        
-        txn.commit();
+        pool->run([&](pqxx::connection& conn) {
+            pqxx::work txn(conn);
+
+            txn.exec_prepared("delete_report", work_id);
+
+            txn.exec_prepared(
+                "insert_report",
+                work_id,
+                plagiarism_found,
+                similarity_percentage,
+                matched_work_id,
+                matched_student_name,
+                report_data
+            );
+
+            std::string status = plagiarism_found ? "plagiarism_found" : "checked_ok";
+            txn.exec_prepared("update_work_status", status, work_id);
+            
+            txn.commit();
+        });
         std::cout << "[DATABASE] Report saved for work ID: " << work_id << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] save_report: " << e.what() << std::endl;
@@ -219,17 +418,16 @@ void Database::save_report(int work_id,
 
 std::string Database::get_report_json(int work_id) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT report_data::text as report FROM reports WHERE work_id = $1",
-            work_id
-        );
-        
-        if (result.empty()) {
-            return "{}";
-        }
-        
-        return result[0]["report"].as<std::string>();
+        return pool->run([&](pqxx::connection& conn) -> std::string {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("get_report_json", work_id);
+            
+            if (result.empty()) {
+                return "{}";
+            }
+            
+            return result[0]["report"].as<std::string>();
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] get_report_json: " << e.what() << std::endl;
         return "{}";
@@ -238,44 +436,47 @@ std::string Database::get_report_json(int work_id) {
 
 bool Database::report_exists(int work_id) {
     try {
-        pqxx::work txn(*conn);
-        pqxx::result result = txn.exec_params(
-            "SELECT COUNT(*) as count FROM reports WHERE work_id = $1",
-            work_id
-        );
-        
-        return result[0]["count"].as<int>() > 0;
+        return pool->run([&](pqxx::connection& conn) -> bool {
+            pqxx::work txn(conn);
+            pqxx::result result = txn.exec_prepared("count_reports", work_id);
+            
+            return result[0]["count"].as<int>() > 0;
+        });
     } catch (const std::exception& e) {
         std::cerr << "[DATABASE ERROR] report_exists: " << e.what() << std::endl;
         return false;
     }
 }
 
-pqxx::result Database::get_works_by_assignment(const std::string& assignment_id) {
+pqxx::result Database::get_works_page(const std::string& assignment_id,
+                                      const std::string& cursor_time,
+                                      int cursor_id,
+                                      int limit) {
     try {
-        pqxx::work txn(*conn);
-        return txn.exec_params(
-            "SELECT id, student_id, student_name, original_filename, "
-            "upload_time, status FROM works WHERE assignment_id = $1 ORDER BY upload_time DESC",
-            assignment_id
-        );
+        return pool->run([&](pqxx::connection& conn) -> pqxx::result {
+            pqxx::read_transaction txn(conn);
+            if (cursor_time.empty()) {
+                return txn.exec_prepared("get_works_first_page", assignment_id, limit);
+            }
+            return txn.exec_prepared("get_works_next_page", assignment_id, cursor_time, cursor_id, limit);
+        });
     } catch (const std::exception& e) {
-        std::cerr << "[DATABASE ERROR] get_works_by_assignment: " << e.what() << std::endl;
+        std::cerr << "[DATABASE ERROR] get_works_page: " << e.what() << std::endl;
         throw;
     }
 }
 
-pqxx::result Database::get_all_reports() {
+pqxx::result Database::get_reports_page(const std::string& cursor_time, int cursor_id, int limit) {
     try {
-        pqxx::work txn(*conn);
-        return txn.exec(
-            "SELECT r.id, r.work_id, w.student_name, w.assignment_name, "
-            "r.plagiarism_found, r.similarity_percentage, r.matched_student_name, "
-            "r.analysis_time FROM reports r JOIN works w ON r.work_id = w.id "
-            "ORDER BY r.analysis_time DESC"
-        );
+        return pool->run([&](pqxx::connection& conn) -> pqxx::result {
+            pqxx::read_transaction txn(conn);
+            if (cursor_time.empty()) {
+                return txn.exec_prepared("get_reports_first_page", limit);
+            }
+            return txn.exec_prepared("get_reports_next_page", cursor_time, cursor_id, limit);
+        });
     } catch (const std::exception& e) {
-        std::cerr << "[DATABASE ERROR] get_all_reports: " << e.what() << std::endl;
+        std::cerr << "[DATABASE ERROR] get_reports_page: " << e.what() << std::endl;
         throw;
     }
 }
\ No newline at end of file
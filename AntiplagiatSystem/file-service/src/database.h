@@ -1,14 +1,16 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
 #include <pqxx/pqxx>
+#include "connection_pool.h"
 
 class Database {
 private:
-    std::unique_ptr<pqxx::connection> conn;
+    std::unique_ptr<ConnectionPool> pool;
     
 public:
-    Database(const std::string& connection_string);
+    Database(const std::string& connection_string, size_t pool_size = 8);
     ~Database();
 
     bool is_connected() const;
@@ -21,7 +23,29 @@ public:
                   const std::string& original_filename,
                   const std::string& file_hash);
     
+    struct NewWork {
+        std::string student_id;
+        std::string student_name;
+        std::string assignment_id;
+        std::string assignment_name;
+        std::string file_path;
+        std::string original_filename;
+        std::string file_hash;
+    };
+
+    // Batch form of save_work: one transaction and one multi-row INSERT.
+    // Returns the work id for every input in order, with the same duplicate
+    // semantics as calling save_work on each work in turn.
+    std::vector<int> save_works(const std::vector<NewWork>& works);
+
+    struct FileInfo {
+        std::string file_path;
+        std::string file_hash;
+        std::string original_filename;
+    };
+
     std::string get_file_path(int work_id);
+    FileInfo get_file_info(int work_id);
     std::string get_file_hash(int work_id);
     std::string get_student_id(int work_id);
     bool hash_exists(const std::string& file_hash);
@@ -38,9 +62,18 @@ public:
     std::string get_report_json(int work_id);
     bool report_exists(int work_id);
 
-    pqxx::result get_works_by_assignment(const std::string& assignment_id);
-    pqxx::result get_all_reports();
+    // Keyset pagination, newest first. An empty cursor_time requests the first
+    // page; otherwise rows strictly older than (cursor_time, cursor_id) are
+    // returned. Every row carries a cursor_time column for the next request.
+    static constexpr const char* CURSOR_TIME_FORMAT = "YYYYMMDDHH24MISSUS";
+
+    pqxx::result get_works_page(const std::string& assignment_id,
+                                const std::string& cursor_time,
+                                int cursor_id,
+                                int limit);
+    pqxx::result get_reports_page(const std::string& cursor_time, int cursor_id, int limit);
     
 private:
-    void create_tables();
+    void create_tables(pqxx::connection& conn);
+    static void prepare_statements(pqxx::connection& conn);
 };
\ No newline at end of file
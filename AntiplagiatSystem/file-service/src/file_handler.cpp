@@ -1,15 +1,187 @@
 #include "file_handler.h"
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <openssl/sha.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <cpprest/rawptrstream.h>
+#include <cpprest/producerconsumerstream.h>
+#include <cpprest/containerstream.h>
+#include <unordered_map>
+#include "mapped_file.h"
+#include "sha256.h"
 
 namespace fs = std::filesystem;
 
+namespace {
+
+const size_t STREAM_CHUNK_SIZE = 256 * 1024;
+const size_t JSON_STREAM_FLUSH_SIZE = 64 * 1024;
+const size_t MAX_BULK_WORKS = 1000;
+const int DEFAULT_PAGE_LIMIT = 100;
+const int MAX_PAGE_LIMIT = 1000;
+
+struct PageRequest {
+    std::string cursor_time;
+    int cursor_id = 0;
+    int limit = DEFAULT_PAGE_LIMIT;
+};
+
+// Cursors look like "<cursor_time>-<id>", e.g. "20240501120000123456-17".
+bool parse_page_request(const std::map<utility::string_t, utility::string_t>& query,
+                        PageRequest& page, std::string& error) {
+    auto limit_param = query.find(U("limit"));
+    if (limit_param != query.end()) {
+        std::string value = utility::conversions::to_utf8string(limit_param->second);
+        if (value.empty() || value.size() > 6 || value.find_first_not_of("0123456789") != std::string::npos) {
+            error = "limit must be a positive integer";
+            return false;
+        }
+        page.limit = std::stoi(value);
+        if (page.limit <= 0) {
+            error = "limit must be a positive integer";
+            return false;
+        }
+        page.limit = std::min(page.limit, MAX_PAGE_LIMIT);
+    }
+
+    auto cursor_param = query.find(U("cursor"));
+    if (cursor_param != query.end() && !cursor_param->second.empty()) {
+        std::string cursor = utility::conversions::to_utf8string(uri::decode(cursor_param->second));
+        size_t dash = cursor.find('-');
+        std::string time = cursor.substr(0, dash);
+        std::string id = dash == std::string::npos ? "" : cursor.substr(dash + 1);
+
+        auto is_digits = [](const std::string& value, size_t max_size) {
+            return !value.empty() && value.size() <= max_size &&
+                   value.find_first_not_of("0123456789") == std::string::npos;
+        };
+        if (time.size() != 20 || !is_digits(time, 20) || !is_digits(id, 9)) {
+            error = "Invalid cursor";
+            return false;
+        }
+
+        page.cursor_time = time;
+        page.cursor_id = std::stoi(id);
+    }
+
+    return true;
+}
+
+std::string next_cursor(const pqxx::result& rows, int limit) {
+    if (rows.empty() || static_cast<int>(rows.size()) < limit) {
+        return "";
+    }
+    const auto& last = rows[rows.size() - 1];
+    if (last["cursor_time"].is_null()) {
+        return "";
+    }
+    return last["cursor_time"].as<std::string>() + "-" + std::to_string(last["id"].as<int>());
+}
+
+std::string json_string(const std::string& value) {
+    return utility::conversions::to_utf8string(
+        json::value::string(utility::conversions::to_string_t(value)).serialize());
+}
+
+enum class RangeStatus { None, Satisfiable, Unsatisfiable };
+
+// Digits only; a position too large for size_t is still a valid spec.
+size_t parse_position(const std::string& digits) {
+    try {
+        return static_cast<size_t>(std::stoull(digits));
+    } catch (const std::out_of_range&) {
+        return SIZE_MAX;
+    }
+}
+
+// Single byte ranges only ("bytes=a-b", "bytes=a-", "bytes=-n"). Anything
+// else, including "a-b" with b < a, is an invalid range set that RFC 7233
+// says to ignore, so the whole file is served; only a valid range that
+// misses the file is Unsatisfiable.
+RangeStatus parse_range(const std::string& header, size_t size, size_t& start, size_t& length) {
+    const std::string prefix = "bytes=";
+    if (header.compare(0, prefix.size(), prefix) != 0 ||
+        header.find(',') != std::string::npos) {
+        return RangeStatus::None;
+    }
+
+    std::string spec = header.substr(prefix.size());
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return RangeStatus::None;
+    }
+
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+    auto is_number = [](const std::string& value) {
+        return !value.empty() && value.find_first_not_of("0123456789") == std::string::npos;
+    };
+
+    if (first.empty()) {
+        if (!is_number(last)) {
+            return RangeStatus::None;
+        }
+        size_t suffix = parse_position(last);
+        if (suffix == 0 || size == 0) {
+            return RangeStatus::Unsatisfiable;
+        }
+        length = std::min(suffix, size);
+        start = size - length;
+        return RangeStatus::Satisfiable;
+    }
+
+    if (!is_number(first) || (!last.empty() && !is_number(last))) {
+        return RangeStatus::None;
+    }
+
+    size_t from = parse_position(first);
+    size_t to = last.empty() ? SIZE_MAX : parse_position(last);
+    if (to < from) {
+        return RangeStatus::None;
+    }
+    if (from >= size) {
+        return RangeStatus::Unsatisfiable;
+    }
+    start = from;
+    length = std::min(to, size - 1) - from + 1;
+    return RangeStatus::Satisfiable;
+}
+
+bool etag_matches(const utility::string_t& header, const utility::string_t& etag) {
+    if (header == U("*")) {
+        return true;
+    }
+
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t comma = header.find(U(','), pos);
+        utility::string_t candidate = header.substr(pos, comma == utility::string_t::npos ?
+                                                          utility::string_t::npos : comma - pos);
+        size_t begin = candidate.find_first_not_of(U(" \t"));
+        size_t end = candidate.find_last_not_of(U(" \t"));
+        if (begin != utility::string_t::npos) {
+            candidate = candidate.substr(begin, end - begin + 1);
+            if (candidate.compare(0, 2, U("W/")) == 0) {
+                candidate = candidate.substr(2);
+            }
+            if (candidate == etag) {
+                return true;
+            }
+        }
+        if (comma == utility::string_t::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+}
+
 FileHandler::FileHandler(const std::string& url, const std::string& db_conn_str, const std::string& upload_dir)
-    : listener(url), upload_dir(upload_dir) {
+    : listener(url), upload_dir(upload_dir), blob_store(upload_dir) {
     
     try {
         db = std::make_unique<Database>(db_conn_str);
@@ -36,6 +208,10 @@ FileHandler::FileHandler(const std::string& url, const std::string& db_conn_str,
             
             if (path == U("/upload")) {
                 handle_upload(request);
+            } else if (path == U("/upload/stream")) {
+                handle_upload_stream(request);
+            } else if (path == U("/upload/bulk")) {
+                handle_upload_bulk(request);
             } else {
                 send_error_response(request, status_codes::NotFound,
                     "not_found", "Endpoint not found");
@@ -108,22 +284,24 @@ void FileHandler::handle_upload(http_request request) {
                 std::string file_content = data[U("file_content")].as_string();
                 std::string original_filename = data[U("filename")].as_string();
 
-                std::string filename = generate_filename(original_filename, student_id);
-                std::string filepath = upload_dir + "/" + filename;
-
-                std::ofstream file(filepath, std::ios::binary);
-                if (!file) {
-                    send_error_response(request, status_codes::InternalError,
-                        "file_save_error", "Failed to save file");
-                    return;
+                std::string file_hash = Sha256::digest(file_content.data(), file_content.size());
+
+                BlobStore::Pin pin = blob_store.pin(file_hash);
+                if (!blob_store.exists(file_hash)) {
+                    std::string temp_path = blob_store.make_temp_path();
+                    std::ofstream file(temp_path, std::ios::binary);
+                    if (!file) {
+                        send_error_response(request, status_codes::InternalError,
+                            "file_save_error", "Failed to save file");
+                        return;
+                    }
+                    file.write(file_content.c_str(), file_content.size());
+                    file.close();
+                    blob_store.commit(temp_path, file_hash);
                 }
-                file.write(file_content.c_str(), file_content.size());
-                file.close();
 
-                std::string file_hash = calculate_file_hash(filepath);
-
-                int work_id = db->save_work(student_id, student_name, assignment_id,
-                                           assignment_name, filepath, original_filename, file_hash);
+                int work_id = register_work(pin, file_hash, student_id, student_name,
+                                            assignment_id, assignment_name, original_filename);
 
                 json::value response;
                 response[U("success")] = json::value::boolean(true);
@@ -149,6 +327,184 @@ void FileHandler::handle_upload(http_request request) {
     }
 }
 
+void FileHandler::handle_upload_stream(http_request request) {
+    try {
+        auto query = uri::split_query(request.request_uri().query());
+        auto param = [&query](const utility::string_t& name) {
+            auto it = query.find(name);
+            return it == query.end() ? std::string() :
+                utility::conversions::to_utf8string(uri::decode(it->second));
+        };
+
+        std::string student_id = param(U("student_id"));
+        std::string student_name = param(U("student_name"));
+        std::string assignment_id = param(U("assignment_id"));
+        std::string assignment_name = param(U("assignment_name"));
+        std::string original_filename = param(U("filename"));
+
+        if (student_id.empty() || student_name.empty() ||
+            assignment_id.empty() || original_filename.empty()) {
+            send_error_response(request, status_codes::BadRequest,
+                "invalid_data", "student_id, student_name, assignment_id and filename "
+                "query parameters are required");
+            return;
+        }
+
+        std::string temp_path = blob_store.make_temp_path();
+        std::string file_hash = save_file(request.body(), temp_path);
+        BlobStore::Pin pin = blob_store.pin(file_hash);
+        std::string filepath = blob_store.commit(temp_path, file_hash);
+
+        int work_id = register_work(pin, file_hash, student_id, student_name,
+                                    assignment_id, assignment_name, original_filename);
+
+        json::value response;
+        response[U("success")] = json::value::boolean(true);
+        response[U("work_id")] = json::value::number(work_id);
+        response[U("file_hash")] = json::value::string(
+            utility::conversions::to_string_t(file_hash));
+        response[U("size")] = json::value::number(static_cast<uint64_t>(fs::file_size(filepath)));
+        response[U("message")] = json::value::string(U("File uploaded successfully"));
+        response[U("status")] = json::value::string(U("uploaded"));
+
+        send_json_response(request, status_codes::Created, response);
+
+    } catch (const std::exception& e) {
+        std::cerr << "[FILE SERVICE ERROR] Stream upload: " << e.what() << std::endl;
+        send_error_response(request, status_codes::InternalError,
+            "upload_error", e.what());
+    }
+}
+
+void FileHandler::handle_upload_bulk(http_request request) {
+    struct BulkWork {
+        size_t line;
+        Database::NewWork work;
+        std::string content;
+    };
+
+    try {
+        // NDJSON: one /upload-style object per line, read line by line.
+        auto body = request.body();
+        std::vector<BulkWork> works;
+        json::value errors = json::value::array();
+        size_t error_count = 0;
+        size_t line_number = 0;
+
+        while (true) {
+            concurrency::streams::container_buffer<std::string> line_buffer;
+            size_t read = body.read_line(line_buffer).get();
+            std::string line = std::move(line_buffer.collection());
+            if (read == 0 && line.empty() && body.is_eof()) {
+                break;
+            }
+            line_number++;
+
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            if (works.size() >= MAX_BULK_WORKS) {
+                send_error_response(request, status_codes::RequestEntityTooLarge, "too_many_works",
+                    "At most " + std::to_string(MAX_BULK_WORKS) + " works per bulk upload");
+                return;
+            }
+
+            try {
+                json::value data = json::value::parse(utility::conversions::to_string_t(line));
+                if (!validate_upload_data(data)) {
+                    throw std::invalid_argument("Missing required fields");
+                }
+
+                BulkWork item;
+                item.line = line_number;
+                item.work.student_id = data[U("student_id")].as_string();
+                item.work.student_name = data[U("student_name")].as_string();
+                item.work.assignment_id = data[U("assignment_id")].as_string();
+                item.work.assignment_name = data[U("assignment_name")].as_string();
+                item.work.original_filename = data[U("filename")].as_string();
+                item.content = data[U("file_content")].as_string();
+                works.push_back(std::move(item));
+            } catch (const std::exception& e) {
+                json::value error;
+                error[U("line")] = json::value::number(static_cast<uint64_t>(line_number));
+                error[U("message")] = json::value::string(utility::conversions::to_string_t(e.what()));
+                errors[error_count++] = error;
+            }
+        }
+
+        std::vector<std::string_view> contents;
+        contents.reserve(works.size());
+        for (const auto& item : works) {
+            contents.push_back(item.content);
+        }
+        std::vector<std::string> hashes = Sha256::hash_buffers(contents);
+
+        // One pin per distinct hash, held until the batch insert resolves.
+        std::unordered_map<std::string, BlobStore::Pin> pins;
+        std::vector<Database::NewWork> rows;
+        rows.reserve(works.size());
+        for (size_t i = 0; i < works.size(); i++) {
+            const std::string& file_hash = hashes[i];
+            if (pins.count(file_hash) == 0) {
+                pins.emplace(file_hash, blob_store.pin(file_hash));
+            }
+            if (!blob_store.exists(file_hash)) {
+                std::string temp_path = blob_store.make_temp_path();
+                std::ofstream file(temp_path, std::ios::binary);
+                if (!file) {
+                    throw std::runtime_error("Failed to save file for line " + std::to_string(works[i].line));
+                }
+                file.write(works[i].content.data(), works[i].content.size());
+                file.close();
+                blob_store.commit(temp_path, file_hash);
+            }
+
+            works[i].work.file_hash = file_hash;
+            works[i].work.file_path = blob_store.path_for(file_hash);
+            rows.push_back(works[i].work);
+        }
+
+        std::vector<int> ids;
+        try {
+            ids = db->save_works(rows);
+        } catch (...) {
+            for (auto& [file_hash, pin] : pins) {
+                const std::string& hash = file_hash;
+                pin.release_and_remove([&] { return db->hash_exists(hash); });
+            }
+            throw;
+        }
+
+        json::value saved = json::value::array();
+        for (size_t i = 0; i < works.size(); i++) {
+            json::value item;
+            item[U("line")] = json::value::number(static_cast<uint64_t>(works[i].line));
+            item[U("work_id")] = json::value::number(ids[i]);
+            item[U("file_hash")] = json::value::string(utility::conversions::to_string_t(hashes[i]));
+            item[U("filename")] = json::value::string(
+                utility::conversions::to_string_t(works[i].work.original_filename));
+            saved[i] = item;
+        }
+
+        json::value response;
+        response[U("success")] = json::value::boolean(error_count == 0);
+        response[U("uploaded")] = json::value::number(static_cast<uint64_t>(works.size()));
+        response[U("failed")] = json::value::number(static_cast<uint64_t>(error_count));
+        response[U("works")] = saved;
+        response[U("errors")] = errors;
+
+        std::cout << "[FILE SERVICE] Bulk upload: " << works.size() << " works, "
+                  << error_count << " rejected lines" << std::endl;
+        send_json_response(request, works.empty() ? status_codes::BadRequest : status_codes::Created, response);
+
+    } catch (const std::exception& e) {
+        std::cerr << "[FILE SERVICE ERROR] Bulk upload: " << e.what() << std::endl;
+        send_error_response(request, status_codes::InternalError,
+            "upload_error", e.what());
+    }
+}
+
 void FileHandler::handle_get_file(http_request request) {
     try {
         auto path = request.relative_uri().path();
@@ -163,30 +519,81 @@ void FileHandler::handle_get_file(http_request request) {
         
         int work_id = std::stoi(path_str.substr(pos + 1));
 
-        std::string filepath = db->get_file_path(work_id);
+        auto info = db->get_file_info(work_id);
         
-        if (!fs::exists(filepath)) {
+        if (!fs::exists(info.file_path)) {
             send_error_response(request, status_codes::NotFound,
                 "file_not_found", "File not found on server");
             return;
         }
 
-        std::ifstream file(filepath, std::ios::binary);
-        if (!file) {
+        const utility::string_t etag = utility::conversions::to_string_t("\"" + info.file_hash + "\"");
+        const auto& headers = request.headers();
+
+        auto if_none_match = headers.find(U("If-None-Match"));
+        if (if_none_match != headers.end() && etag_matches(if_none_match->second, etag)) {
+            http_response response(status_codes::NotModified);
+            response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
+            response.headers().add(U("ETag"), etag);
+            request.reply(response);
+            return;
+        }
+
+        std::shared_ptr<MappedFile> file;
+        try {
+            file = MappedFile::open(info.file_path);
+        } catch (const std::exception& e) {
+            std::cerr << "[FILE SERVICE ERROR] Map file: " << e.what() << std::endl;
             send_error_response(request, status_codes::InternalError,
                 "file_read_error", "Failed to read file");
             return;
         }
-        
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string content = buffer.str();
 
-        http_response response(status_codes::OK);
+        size_t start = 0;
+        size_t length = file->size();
+        RangeStatus range = RangeStatus::None;
+
+        auto range_header = headers.find(U("Range"));
+        auto if_range = headers.find(U("If-Range"));
+        bool range_allowed = if_range == headers.end() || if_range->second == etag;
+        if (range_header != headers.end() && range_allowed) {
+            range = parse_range(utility::conversions::to_utf8string(range_header->second),
+                                file->size(), start, length);
+        }
+
+        if (range == RangeStatus::Unsatisfiable) {
+            http_response response(status_codes::RangeNotSatisfiable);
+            response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
+            response.headers().add(U("Content-Range"), utility::conversions::to_string_t(
+                "bytes */" + std::to_string(file->size())));
+            request.reply(response);
+            return;
+        }
+
+        auto body = concurrency::streams::rawptr_stream<uint8_t>::open_istream(
+            reinterpret_cast<const uint8_t*>(file->data()) + start, length);
+
+        http_response response(range == RangeStatus::Satisfiable ?
+                               status_codes::PartialContent : status_codes::OK);
         response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
-        response.headers().add(U("Content-Type"), U("application/octet-stream"));
-        response.set_body(content);
-        request.reply(response);
+        response.headers().add(U("Accept-Ranges"), U("bytes"));
+        response.headers().add(U("ETag"), etag);
+        if (range == RangeStatus::Satisfiable) {
+            response.headers().add(U("Content-Range"), utility::conversions::to_string_t(
+                "bytes " + std::to_string(start) + "-" + std::to_string(start + length - 1) +
+                "/" + std::to_string(file->size())));
+        }
+        response.set_body(body, length, U("application/octet-stream"));
+
+        // The body streams straight from the mapping, so keep it alive until
+        // the response has been sent.
+        request.reply(response).then([file](pplx::task<void> task) {
+            try {
+                task.get();
+            } catch (const std::exception& e) {
+                std::cerr << "[FILE SERVICE ERROR] Send file: " << e.what() << std::endl;
+            }
+        });
         
     } catch (const std::exception& e) {
         std::cerr << "[FILE SERVICE ERROR] Get file: " << e.what() << std::endl;
@@ -200,11 +607,13 @@ void FileHandler::handle_get_works(http_request request) {
         auto query = uri::split_query(request.request_uri().query());
         std::string assignment_id;
 
-        for (const auto& param : query) {
-            if (param.first == U("assignment_id")) {
-                assignment_id = utility::conversions::to_utf8string(param.second);
-                break;
-            }
+        auto assignment_param = query.find(U("assignment_id"));
+        if (assignment_param != query.end()) {
+            assignment_id = utility::conversions::to_utf8string(uri::decode(assignment_param->second));
+        } else {
+            std::string path = utility::conversions::to_utf8string(
+                uri::decode(request.relative_uri().path()));
+            assignment_id = path.substr(path.find_last_of('/') + 1);
         }
         
         if (assignment_id.empty()) {
@@ -213,13 +622,22 @@ void FileHandler::handle_get_works(http_request request) {
             return;
         }
 
-        auto result = db->get_works_by_assignment(assignment_id);
+        PageRequest page;
+        std::string error;
+        if (!parse_page_request(query, page, error)) {
+            send_error_response(request, status_codes::BadRequest, "invalid_parameter", error);
+            return;
+        }
+
+        auto result = db->get_works_page(assignment_id, page.cursor_time, page.cursor_id, page.limit);
+        std::string cursor = next_cursor(result, page.limit);
 
-        json::value response;
-        json::value works_array = json::value::array();
-        
-        int index = 0;
-        for (const auto& row : result) {
+        std::string head = "{\"assignment_id\":" + json_string(assignment_id) +
+                           ",\"count\":" + std::to_string(result.size()) +
+                           ",\"next_cursor\":" + (cursor.empty() ? "null" : json_string(cursor)) +
+                           ",\"works\":[";
+
+        stream_json_rows(request, head, result, [](const pqxx::row& row) {
             json::value work;
             work[U("id")] = json::value::number(row["id"].as<int>());
             work[U("student_id")] = json::value::string(
@@ -232,16 +650,8 @@ void FileHandler::handle_get_works(http_request request) {
                 utility::conversions::to_string_t(row["upload_time"].as<std::string>()));
             work[U("status")] = json::value::string(
                 utility::conversions::to_string_t(row["status"].as<std::string>()));
-            
-            works_array[index++] = work;
-        }
-        
-        response[U("assignment_id")] = json::value::string(
-            utility::conversions::to_string_t(assignment_id));
-        response[U("count")] = json::value::number(result.size());
-        response[U("works")] = works_array;
-        
-        send_json_response(request, status_codes::OK, response);
+            return work;
+        });
         
     } catch (const std::exception& e) {
         std::cerr << "[FILE SERVICE ERROR] Get works: " << e.what() << std::endl;
@@ -252,35 +662,39 @@ void FileHandler::handle_get_works(http_request request) {
 
 void FileHandler::handle_get_reports(http_request request) {
     try {
-        auto result = db->get_all_reports();
-        
-        json::value response;
-        json::value reports_array = json::value::array();
-        
-        int index = 0;
-        for (const auto& row : result) {
+        auto query = uri::split_query(request.request_uri().query());
+
+        PageRequest page;
+        std::string error;
+        if (!parse_page_request(query, page, error)) {
+            send_error_response(request, status_codes::BadRequest, "invalid_parameter", error);
+            return;
+        }
+
+        auto result = db->get_reports_page(page.cursor_time, page.cursor_id, page.limit);
+        std::string cursor = next_cursor(result, page.limit);
+
+        std::string head = "{\"count\":" + std::to_string(result.size()) +
+                           ",\"next_cursor\":" + (cursor.empty() ? "null" : json_string(cursor)) +
+                           ",\"reports\":[";
+
+        stream_json_rows(request, head, result, [](const pqxx::row& row) {
             json::value report;
             report[U("id")] = json::value::number(row["id"].as<int>());
             report[U("work_id")] = json::value::number(row["work_id"].as<int>());
             report[U("student_name")] = json::value::string(
                 utility::conversions::to_string_t(row["student_name"].as<std::string>()));
             report[U("assignment_name")] = json::value::string(
-                utility::conversions::to_string_t(row["assignment_name"].as<std::string>()));
+                utility::conversions::to_string_t(row["assignment_name"].as<std::string>("")));
             report[U("plagiarism_found")] = json::value::boolean(row["plagiarism_found"].as<bool>());
             report[U("similarity_percentage")] = json::value::number(
                 row["similarity_percentage"].as<double>());
             report[U("matched_student_name")] = json::value::string(
-                utility::conversions::to_string_t(row["matched_student_name"].as<std::string>()));
+                utility::conversions::to_string_t(row["matched_student_name"].as<std::string>("")));
             report[U("analysis_time")] = json::value::string(
                 utility::conversions::to_string_t(row["analysis_time"].as<std::string>()));
-            
-            reports_array[index++] = report;
-        }
-        
-        response[U("count")] = json::value::number(result.size());
-        response[U("reports")] = reports_array;
-        
-        send_json_response(request, status_codes::OK, response);
+            return report;
+        });
         
     } catch (const std::exception& e) {
         std::cerr << "[FILE SERVICE ERROR] Get reports: " << e.what() << std::endl;
@@ -289,6 +703,54 @@ void FileHandler::handle_get_reports(http_request request) {
     }
 }
 
+void FileHandler::stream_json_rows(http_request request,
+                                   const std::string& head,
+                                   const pqxx::result& rows,
+                                   const std::function<json::value(const pqxx::row&)>& to_json) {
+    // The reply goes out with a stream body and no Content-Length, so it is
+    // sent chunked while the rows are still being serialized into it; the
+    // page never exists as one json::value or one string.
+    concurrency::streams::producer_consumer_buffer<uint8_t> buffer;
+
+    http_response response(status_codes::OK);
+    response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
+    response.set_body(buffer.create_istream(), U("application/json"));
+    request.reply(response);
+
+    std::string chunk;
+    chunk.reserve(JSON_STREAM_FLUSH_SIZE * 2);
+    auto flush = [&buffer, &chunk]() {
+        if (!chunk.empty()) {
+            buffer.putn_nocopy(reinterpret_cast<const uint8_t*>(chunk.data()), chunk.size()).wait();
+            chunk.clear();
+        }
+    };
+
+    try {
+        chunk += head;
+        bool first = true;
+        for (const auto& row : rows) {
+            if (!first) {
+                chunk += ',';
+            }
+            first = false;
+            chunk += utility::conversions::to_utf8string(to_json(row).serialize());
+
+            if (chunk.size() >= JSON_STREAM_FLUSH_SIZE) {
+                flush();
+            }
+        }
+        chunk += "]}";
+        flush();
+    } catch (const std::exception& e) {
+        // Headers are already sent; closing early truncates the body, which
+        // the client sees as an incomplete chunked response.
+        std::cerr << "[FILE SERVICE ERROR] Stream rows: " << e.what() << std::endl;
+    }
+
+    buffer.close(std::ios_base::out).wait();
+}
+
 void FileHandler::handle_options(http_request request) {
     http_response response(status_codes::OK);
     response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
@@ -298,52 +760,39 @@ void FileHandler::handle_options(http_request request) {
 }
 
 std::string FileHandler::calculate_file_hash(const std::string& filepath) {
-    std::ifstream file(filepath, std::ios::binary);
+    return Sha256::hash_file(filepath);
+}
+
+std::string FileHandler::save_file(const concurrency::streams::istream& stream, const std::string& filepath) {
+    std::ofstream file(filepath, std::ios::binary);
     if (!file) {
-        throw std::runtime_error("Cannot open file for hash calculation: " + filepath);
+        throw std::runtime_error("Failed to save file: " + filepath);
     }
 
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    if (mdctx == nullptr) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
-    }
-    
-    if (EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("Failed to initialize digest");
-    }
-    
-    char buffer[4096];
-    while (file.read(buffer, sizeof(buffer))) {
-        if (EVP_DigestUpdate(mdctx, buffer, file.gcount()) != 1) {
-            EVP_MD_CTX_free(mdctx);
-            throw std::runtime_error("Failed to update digest");
-        }
-    }
-    
-    if (file.gcount() > 0) {
-        if (EVP_DigestUpdate(mdctx, buffer, file.gcount()) != 1) {
-            EVP_MD_CTX_free(mdctx);
-            throw std::runtime_error("Failed to update digest");
+    Sha256 hasher;
+    std::vector<uint8_t> chunk(STREAM_CHUNK_SIZE);
+    auto buffer = stream.streambuf();
+
+    try {
+        while (true) {
+            size_t read = buffer.getn(chunk.data(), chunk.size()).get();
+            if (read == 0) {
+                break;
+            }
+            file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(read));
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + filepath);
+            }
+            hasher.update(chunk.data(), read);
         }
+        file.close();
+    } catch (...) {
+        file.close();
+        fs::remove(filepath);
+        throw;
     }
-    
-    unsigned char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len = 0;
-    
-    if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("Failed to finalize digest");
-    }
-    
-    EVP_MD_CTX_free(mdctx);
 
-    std::stringstream ss;
-    for (unsigned int i = 0; i < hash_len; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-    }
-    
-    return ss.str();
+    return hasher.finish();
 }
 
 bool FileHandler::validate_upload_data(const json::value& data) {
@@ -354,16 +803,20 @@ bool FileHandler::validate_upload_data(const json::value& data) {
            data.has_field(U("file_content"));
 }
 
-std::string FileHandler::generate_filename(const std::string& original_name, const std::string& student_id) {
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-
-    size_t dot_pos = original_name.find_last_of('.');
-    std::string extension = (dot_pos != std::string::npos) ? 
-        original_name.substr(dot_pos) : "";
-
-    return std::to_string(timestamp) + "_" + student_id + "_" + original_name;
+int FileHandler::register_work(BlobStore::Pin& pin,
+                               const std::string& file_hash,
+                               const std::string& student_id,
+                               const std::string& student_name,
+                               const std::string& assignment_id,
+                               const std::string& assignment_name,
+                               const std::string& original_filename) {
+    try {
+        return db->save_work(student_id, student_name, assignment_id, assignment_name,
+                             blob_store.path_for(file_hash), original_filename, file_hash);
+    } catch (...) {
+        pin.release_and_remove([&] { return db->hash_exists(file_hash); });
+        throw;
+    }
 }
 
 void FileHandler::send_json_response(http_request request, status_code status, const json::value& body) {
@@ -4,7 +4,9 @@
 #include <cpprest/filestream.h>
 #include <string>
 #include <memory>
+#include <functional>
 #include "database.h"
+#include "blob_store.h"
 
 using namespace web;
 using namespace web::http;
@@ -15,6 +17,7 @@ private:
     http_listener listener;
     std::unique_ptr<Database> db;
     std::string upload_dir;
+    BlobStore blob_store;
     
 public:
     FileHandler(const std::string& url, const std::string& db_conn_str, const std::string& upload_dir);
@@ -26,16 +29,30 @@ public:
 private:
     void handle_health(http_request request);
     void handle_upload(http_request request);
+    void handle_upload_stream(http_request request);
+    void handle_upload_bulk(http_request request);
     void handle_get_file(http_request request);
     void handle_get_works(http_request request);
     void handle_get_reports(http_request request);
     void handle_options(http_request request);
     
     std::string calculate_file_hash(const std::string& filepath);
-    std::string save_file(const concurrency::streams::istream& stream, const std::string& filename);
+    std::string save_file(const concurrency::streams::istream& stream, const std::string& filepath);
     void send_json_response(http_request request, status_code status, const json::value& body);
+    void stream_json_rows(http_request request,
+                          const std::string& head,
+                          const pqxx::result& rows,
+                          const std::function<json::value(const pqxx::row&)>& to_json);
     void send_error_response(http_request request, status_code status, const std::string& error, const std::string& message);
 
     bool validate_upload_data(const json::value& data);
-    std::string generate_filename(const std::string& original_name, const std::string& student_id);
+    // Inserts the works row; on failure the pinned blob is removed unless
+    // another upload holds it or a row references it.
+    int register_work(BlobStore::Pin& pin,
+                      const std::string& file_hash,
+                      const std::string& student_id,
+                      const std::string& student_name,
+                      const std::string& assignment_id,
+                      const std::string& assignment_name,
+                      const std::string& original_filename);
 };
\ No newline at end of file
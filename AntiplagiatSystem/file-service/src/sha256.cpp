@@ -0,0 +1,153 @@
+#include "sha256.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include "mapped_file.h"
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Owns the per-thread context used by the one-shot helpers; it is reset with
+// EVP_DigestInit_ex for every digest instead of being reallocated.
+struct ThreadContext {
+    EVP_MD_CTX* ctx;
+
+    ThreadContext() : ctx(EVP_MD_CTX_new()) {
+        if (ctx == nullptr) {
+            throw std::runtime_error("Failed to create EVP_MD_CTX");
+        }
+    }
+
+    ~ThreadContext() {
+        EVP_MD_CTX_free(ctx);
+    }
+};
+
+EVP_MD_CTX* thread_context() {
+    thread_local ThreadContext context;
+    return context.ctx;
+}
+
+void run_parallel(size_t count, size_t threads, const std::function<void(size_t)>& job) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+
+    auto worker = [&]() {
+        size_t i;
+        while (!failed && (i = next++) < count) {
+            try {
+                job(i);
+            } catch (...) {
+                if (!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
+
+Sha256::Sha256() {
+    mdctx = EVP_MD_CTX_new();
+    if (mdctx == nullptr) {
+        throw std::runtime_error("Failed to create EVP_MD_CTX");
+    }
+
+    if (EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr) != 1) {
+        EVP_MD_CTX_free(mdctx);
+        throw std::runtime_error("Failed to initialize digest");
+    }
+}
+
+Sha256::~Sha256() {
+    EVP_MD_CTX_free(mdctx);
+}
+
+void Sha256::update(const void* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (EVP_DigestUpdate(mdctx, data, size) != 1) {
+        throw std::runtime_error("Failed to update digest");
+    }
+}
+
+std::string Sha256::finish() {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+
+    if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
+        throw std::runtime_error("Failed to finalize digest");
+    }
+
+    return to_hex(hash, hash_len);
+}
+
+std::string Sha256::digest(const void* data, size_t size) {
+    EVP_MD_CTX* ctx = thread_context();
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+
+    if (EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1 ||
+        (size > 0 && EVP_DigestUpdate(ctx, data, size) != 1) ||
+        EVP_DigestFinal_ex(ctx, hash, &hash_len) != 1) {
+        throw std::runtime_error("Failed to compute digest");
+    }
+
+    return to_hex(hash, hash_len);
+}
+
+std::string Sha256::hash_file(const std::string& filepath) {
+    MappedFile file(filepath);
+    return digest(file.data(), file.size());
+}
+
+std::vector<std::string> Sha256::hash_buffers(const std::vector<std::string_view>& buffers, size_t threads) {
+    std::vector<std::string> hashes(buffers.size());
+    run_parallel(buffers.size(), threads, [&](size_t i) {
+        hashes[i] = digest(buffers[i].data(), buffers[i].size());
+    });
+    return hashes;
+}
+
+std::vector<std::string> Sha256::hash_files(const std::vector<std::string>& filepaths, size_t threads) {
+    std::vector<std::string> hashes(filepaths.size());
+    run_parallel(filepaths.size(), threads, [&](size_t i) {
+        hashes[i] = hash_file(filepaths[i]);
+    });
+    return hashes;
+}
+
+std::string Sha256::to_hex(const unsigned char* bytes, size_t size) {
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        hex[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+    return hex;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <openssl/evp.h>
+
+// Incremental SHA-256 over EVP so data can be hashed while it is written.
+// The static helpers are the one-shot path: they reuse one EVP context per
+// thread, read files through mmap and can spread a batch across cores.
+class Sha256 {
+private:
+    EVP_MD_CTX* mdctx;
+
+public:
+    Sha256();
+    ~Sha256();
+
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void update(const void* data, size_t size);
+    std::string finish();
+
+    static std::string digest(const void* data, size_t size);
+    static std::string hash_file(const std::string& filepath);
+
+    // Results keep the input order. threads == 0 uses every hardware thread.
+    static std::vector<std::string> hash_buffers(const std::vector<std::string_view>& buffers,
+                                                 size_t threads = 0);
+    static std::vector<std::string> hash_files(const std::vector<std::string>& filepaths,
+                                               size_t threads = 0);
+
+    static std::string to_hex(const unsigned char* bytes, size_t size);
+};
@@ -23,7 +23,15 @@ CREATE TABLE IF NOT EXISTS reports (
     status VARCHAR(50) DEFAULT 'completed'
 );
 
+CREATE TABLE IF NOT EXISTS work_fingerprints (
+    work_id INTEGER PRIMARY KEY REFERENCES works(id) ON DELETE CASCADE,
+    fingerprints TEXT NOT NULL,
+    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
 CREATE INDEX IF NOT EXISTS idx_works_file_hash ON works(file_hash);
 CREATE INDEX IF NOT EXISTS idx_works_student_assignment ON works(student_id, assignment_id);
 CREATE INDEX IF NOT EXISTS idx_reports_work_id ON reports(work_id);
-CREATE INDEX IF NOT EXISTS idx_works_status ON works(status);
\ No newline at end of file
+CREATE INDEX IF NOT EXISTS idx_works_status ON works(status);
+CREATE INDEX IF NOT EXISTS idx_works_assignment_upload ON works(assignment_id, upload_time DESC, id DESC);
+CREATE INDEX IF NOT EXISTS idx_reports_analysis_time ON reports(analysis_time DESC, id DESC);
\ No newline at end of file